@@ -0,0 +1,1385 @@
+/*
+ * headless frame benchmark
+ *
+ * compiles demo.c against the sokol_gfx dummy backend, places a synthetic
+ * town of entities and drives frame() to measure CPU cost per frame
+ *
+ * usage: bench [entity_count] [frame_count] [moving_count]
+ *
+ * moving_count entities are turned a little before every frame, the rest of
+ * the town stays static
+ */
+
+#define DEMO_HEADLESS
+#define SOKOL_TRACE_HOOKS
+#include "demo.c"
+
+#include "cgltf.h"
+#include "watt_base64.h"
+
+#include <dirent.h> /* opendir, readdir */
+#include <errno.h>  /* errno */
+#include <fcntl.h>  /* open */
+#include <float.h>  /* FLT_EPSILON */
+#include <stdio.h>  /* printf, fprintf, fflush, snprintf */
+#include <stdlib.h> /* atoi, qsort */
+#include <string.h> /* strerror */
+#include <unistd.h> /* dup, dup2, close, unlink, rmdir */
+
+#define BENCH_DEFAULT_ENTITY_COUNT 1000
+#define BENCH_DEFAULT_FRAME_COUNT 1000
+#define BENCH_DEFAULT_MOVING_COUNT 0
+#define BENCH_WARMUP_FRAME_COUNT 8
+#define BENCH_STARTUP_FILE_COUNT 256
+
+struct bench_counters {
+  int64_t make_buffer;
+  int64_t buffer_bytes;
+  int64_t make_pipeline;
+  int64_t update_buffer;
+  int64_t append_buffer;
+  int64_t apply_pipeline;
+  int64_t apply_bindings;
+  int64_t apply_uniforms;
+  int64_t draw;
+  int64_t instances;
+  int64_t drawn_entities;
+  int64_t culled_entities;
+  int64_t allocs;
+  int64_t alloc_bytes;
+};
+
+static struct bench_counters counters = {0};
+
+/*
+ * allocation counting, bench.sh links with -Wl,--wrap=malloc,... so every
+ * allocation made by demo.c, cgltf, sokol_gfx and watt_* passes through here
+ */
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+int __real_posix_memalign(void **ptr, size_t alignment, size_t size);
+
+/* loader workers allocate concurrently */
+static void count_alloc(size_t size)
+{
+  __atomic_fetch_add(&counters.allocs, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&counters.alloc_bytes, (int64_t)size, __ATOMIC_RELAXED);
+}
+
+void *__wrap_malloc(size_t size)
+{
+  count_alloc(size);
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+  count_alloc(count * size);
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  count_alloc(size);
+  return __real_realloc(ptr, size);
+}
+
+int __wrap_posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+  count_alloc(size);
+  return __real_posix_memalign(ptr, alignment, size);
+}
+
+static void trace_make_buffer(const sg_buffer_desc *desc, sg_buffer result, void *user_data)
+{
+  (void)result;
+  (void)user_data;
+  ++counters.make_buffer;
+  counters.buffer_bytes += desc->size;
+}
+
+/* streamed buffers are allocated up front and initialized once their file is prepared */
+static void trace_init_buffer(sg_buffer buf_id, const sg_buffer_desc *desc, void *user_data)
+{
+  (void)buf_id;
+  (void)user_data;
+  ++counters.make_buffer;
+  counters.buffer_bytes += desc->size;
+}
+
+static void trace_make_pipeline(const sg_pipeline_desc *desc, sg_pipeline result, void *user_data)
+{
+  (void)desc;
+  (void)result;
+  (void)user_data;
+  ++counters.make_pipeline;
+}
+
+static void trace_update_buffer(sg_buffer buf, const void *data_ptr, int data_size, void *user_data)
+{
+  (void)buf;
+  (void)data_ptr;
+  (void)data_size;
+  (void)user_data;
+  ++counters.update_buffer;
+}
+
+static void trace_append_buffer(sg_buffer buf, const void *data_ptr, int data_size, int result, void *user_data)
+{
+  (void)buf;
+  (void)data_ptr;
+  (void)data_size;
+  (void)result;
+  (void)user_data;
+  ++counters.append_buffer;
+}
+
+static void trace_apply_pipeline(sg_pipeline pip, void *user_data)
+{
+  (void)pip;
+  (void)user_data;
+  ++counters.apply_pipeline;
+}
+
+static void trace_apply_bindings(const sg_bindings *bindings, void *user_data)
+{
+  (void)bindings;
+  (void)user_data;
+  ++counters.apply_bindings;
+}
+
+static void trace_apply_uniforms(sg_shader_stage stage, int ub_index, const void *data, int num_bytes, void *user_data)
+{
+  (void)stage;
+  (void)ub_index;
+  (void)data;
+  (void)num_bytes;
+  (void)user_data;
+  ++counters.apply_uniforms;
+}
+
+static void trace_draw(int base_element, int num_elements, int num_instances, void *user_data)
+{
+  (void)base_element;
+  (void)num_elements;
+  (void)user_data;
+  ++counters.draw;
+  counters.instances += num_instances;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+/* demo.c logs every load step and the first frame, keep that out of the report */
+static int stdout_silence(void)
+{
+  fflush(stdout);
+  int saved = dup(STDOUT_FILENO);
+  int null_file = open("/dev/null", O_WRONLY);
+  dup2(null_file, STDOUT_FILENO);
+  close(null_file);
+  return saved;
+}
+
+static void stdout_restore(int saved)
+{
+  fflush(stdout);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+}
+
+/* euler angles of the grid entities, each turned a quarter more than the last */
+static struct vec3 spawn_rotation(int32_t i)
+{
+  return v3(WATT_RAD_FROM_DEG(-90.0f), 0.0f, WATT_RAD_FROM_DEG((float)(i % 4) * 90.0f));
+}
+
+/* lays out a square grid around the origin, cycling through the loaded assets */
+static void spawn_entities(int32_t count)
+{
+  int32_t side = (int32_t)ceilf(sqrtf((float)count));
+  float half_extent = (float)side * 10.0f / 2.0f;
+
+  entity_clear();
+  pool_reserve(&entity_pool, (uint32_t)count);
+  reserve_entity_transforms(count);
+  for (int32_t i = 0; i < count; ++i) {
+    uint32_t entity_id = entity_add(
+      i % asset_count,
+      0,
+      v3(-half_extent + (float)(i % side) * 10.0f + 5.0f, 0.0f, -half_extent + (float)(i / side) * 10.0f + 5.0f),
+      quat_from_euler(spawn_rotation(i)),
+      v3(1.0f, 1.0f, 1.0f));
+    if (i == 1) player_entity_id = entity_id;
+  }
+}
+
+static float max_difference(const float *a, const float *b, int64_t count)
+{
+  float max_error = 0.0f;
+  for (int64_t i = 0; i < count; ++i) {
+    max_error = fmaxf(max_error, fabsf(a[i] - b[i]));
+  }
+  return max_error;
+}
+
+/*
+ * times the per-entity mat4_translate/rotate/scale chain frame() used before
+ * the transform streams against composing from euler angles and from the
+ * quaternions the entities store now, one at a time and batched. every path
+ * starts from the spawn rotations so they can be compared.
+ */
+static void bench_transforms(int32_t iterations)
+{
+  int32_t count = (int32_t)entity_pool.count;
+  struct mat4 *chained = calloc((size_t)count, sizeof(struct mat4));
+  struct mat4 *composed = calloc((size_t)count, sizeof(struct mat4));
+  float *streams = calloc((size_t)count * 7, sizeof(float));
+  assert(chained && composed && streams);
+  struct vec3_soa euler = {streams, streams + count, streams + count * 2};
+  struct quat_soa rotation = {streams + count * 3, streams + count * 4, streams + count * 5, streams + count * 6};
+  struct vec3_soa position = entity_transforms.position;
+  struct vec3_soa scale = entity_transforms.scale;
+  for (int32_t i = 0; i < count; ++i) {
+    struct vec3 e = spawn_rotation(i);
+    struct quat q = quat_from_euler(e);
+    euler.x[i] = e.x;
+    euler.y[i] = e.y;
+    euler.z[i] = e.z;
+    rotation.x[i] = q.x;
+    rotation.y[i] = q.y;
+    rotation.z[i] = q.z;
+    rotation.w[i] = q.w;
+  }
+
+  double start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    for (int32_t i = 0; i < count; ++i) {
+      struct mat4 translated = mat4_translate(mat4_identity(), v3(position.x[i], position.y[i], position.z[i]));
+      struct mat4 rotated_and_translated = mat4_rotate_z(mat4_rotate_y(mat4_rotate_x(translated, euler.x[i]), euler.y[i]), euler.z[i]);
+      chained[i] = mat4_scale(rotated_and_translated, v3(scale.x[i], scale.y[i], scale.z[i]));
+    }
+  }
+  double chained_ms = (time_now_ms() - start) / (double)iterations;
+
+  start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    for (int32_t i = 0; i < count; ++i) {
+      composed[i] = mat4_compose_euler(v3(position.x[i], position.y[i], position.z[i]), v3(euler.x[i], euler.y[i], euler.z[i]), v3(scale.x[i], scale.y[i], scale.z[i]));
+    }
+  }
+  double euler_ms = (time_now_ms() - start) / (double)iterations;
+
+  start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    mat4_compose_euler_soa(composed, position, euler, scale, count);
+  }
+  double euler_batched_ms = (time_now_ms() - start) / (double)iterations;
+  float euler_error = max_difference(&chained[0].x.x, &composed[0].x.x, (int64_t)count * 16);
+
+  start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    for (int32_t i = 0; i < count; ++i) {
+      struct quat q = {rotation.x[i], rotation.y[i], rotation.z[i], rotation.w[i]};
+      composed[i] = mat4_from_trs(v3(position.x[i], position.y[i], position.z[i]), q, v3(scale.x[i], scale.y[i], scale.z[i]));
+    }
+  }
+  double trs_ms = (time_now_ms() - start) / (double)iterations;
+
+  start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    mat4_compose_trs_soa(composed, position, rotation, scale, count);
+  }
+  double trs_batched_ms = (time_now_ms() - start) / (double)iterations;
+  float trs_error = max_difference(&chained[0].x.x, &composed[0].x.x, (int64_t)count * 16);
+
+  free(chained);
+  free(composed);
+  free(streams);
+
+  printf("transform update\n");
+  printf("  %-16s %12.3f ms\n", "chained", chained_ms);
+  printf("  %-16s %12.3f ms\n", "euler", euler_ms);
+  printf("  %-16s %12.3f ms\n", "euler batched", euler_batched_ms);
+  printf("  %-16s %12.3f ms\n", "trs", trs_ms);
+  printf("  %-16s %12.3f ms\n", "trs batched", trs_batched_ms);
+  printf("  %-16s %12.2fx\n", "speedup", chained_ms / trs_batched_ms);
+  printf("  %-16s %12g\n", "euler error", euler_error);
+  printf("  %-16s %12g\n", "trs error", trs_error);
+}
+
+/* bench results are stored here so the timed calls can't be dropped */
+static volatile float bench_sink;
+
+/* distance in representable floats, 0 when bit identical */
+static int64_t float_ulps(float a, float b)
+{
+  int32_t ia, ib;
+  memcpy(&ia, &a, sizeof(ia));
+  memcpy(&ib, &b, sizeof(ib));
+  /* map sign-magnitude onto a monotonic integer line */
+  int64_t la = (ia < 0) ? (int64_t)INT32_MIN - ia : ia;
+  int64_t lb = (ib < 0) ? (int64_t)INT32_MIN - ib : ib;
+  return (la > lb) ? la - lb : lb - la;
+}
+
+/*
+ * checks every math backend against the scalar kernels and times the by
+ * value and pointer entry points. scalar code may be contracted into fma
+ * by the compiler, so results only have to agree to a few rounding errors
+ * of the largest product summed.
+ */
+static void bench_math(int32_t iterations)
+{
+  enum { count = 1024 };
+  static struct mat4 a[count], b[count], expected[3][count], result[count];
+  const float scalar = 1.75f;
+
+  srand(1);
+  for (int32_t i = 0; i < count; ++i) {
+    float *fa = &a[i].x.x;
+    float *fb = &b[i].x.x;
+    for (int32_t k = 0; k < 16; ++k) {
+      fa[k] = ((float)rand() / (float)RAND_MAX - 0.5f) * 200.0f;
+      fb[k] = ((float)rand() / (float)RAND_MAX - 0.5f) * 2.0f;
+    }
+  }
+
+  int32_t best_backend = math_backend();
+  math_backend_set(MATH_BACKEND_SCALAR);
+  for (int32_t i = 0; i < count; ++i) {
+    expected[0][i] = mat4_add(a[i], b[i]);
+    expected[1][i] = mat4_multiply(a[i], b[i]);
+    expected[2][i] = mat4_multiply_scalar(a[i], scalar);
+  }
+
+  printf("mat4 %19s %12s %12s %12s %12s %10s\n", "backend", "add ns", "multiply ns", "into ns", "scalar ns", "max ulps");
+  for (int32_t backend = 0; backend < MATH_BACKEND_COUNT; ++backend) {
+    if (!math_backend_set(backend)) {
+      continue;
+    }
+
+    /* tolerance first, against the kernels through both entry points */
+    int64_t max_ulps = 0;
+    for (int32_t op = 0; op < 3; ++op) {
+      for (int32_t i = 0; i < count; ++i) {
+        result[i] = a[i];
+        if (op == 0) {
+          mat4_add_into(&result[i], &result[i], &b[i]);
+        } else if (op == 1) {
+          mat4_multiply_into(&result[i], &result[i], &b[i]);
+        } else {
+          mat4_multiply_scalar_into(&result[i], &result[i], scalar);
+        }
+        struct mat4 by_value = (op == 0) ? mat4_add(a[i], b[i]) : (op == 1) ? mat4_multiply(a[i], b[i]) : mat4_multiply_scalar(a[i], scalar);
+        if (memcmp(&by_value, &result[i], sizeof(struct mat4)) != 0) {
+          printf("math: %s by value and in place results differ\n", math_backend_name(backend));
+          exit(1);
+        }
+        for (int32_t k = 0; k < 16; ++k) {
+          float got = (&result[i].x.x)[k];
+          float want = (&expected[op][i].x.x)[k];
+          float magnitude = (op == 0) ? fabsf((&a[i].x.x)[k]) + fabsf((&b[i].x.x)[k]) : (op == 1) ? 400.0f : fabsf(want);
+          if (fabsf(got - want) > 4.0f * FLT_EPSILON * magnitude) {
+            printf("math: %s differs from scalar, %g instead of %g\n", math_backend_name(backend), got, want);
+            exit(1);
+          }
+          max_ulps = (float_ulps(got, want) > max_ulps) ? float_ulps(got, want) : max_ulps;
+        }
+      }
+    }
+
+    float sink = 0.0f;
+    double add_start = time_now_ms();
+    for (int32_t n = 0; n < iterations; ++n) {
+      for (int32_t i = 0; i < count; ++i) {
+        sink += mat4_add(a[i], b[i]).w.w;
+      }
+    }
+    double add_ms = time_now_ms() - add_start;
+
+    double multiply_start = time_now_ms();
+    for (int32_t n = 0; n < iterations; ++n) {
+      for (int32_t i = 0; i < count; ++i) {
+        sink += mat4_multiply(a[i], b[i]).w.w;
+      }
+    }
+    double multiply_ms = time_now_ms() - multiply_start;
+
+    double into_start = time_now_ms();
+    for (int32_t n = 0; n < iterations; ++n) {
+      for (int32_t i = 0; i < count; ++i) {
+        mat4_multiply_into(&result[i], &a[i], &b[i]);
+      }
+      sink += result[n % count].w.w;
+    }
+    double into_ms = time_now_ms() - into_start;
+
+    double scalar_start = time_now_ms();
+    for (int32_t n = 0; n < iterations; ++n) {
+      for (int32_t i = 0; i < count; ++i) {
+        sink += mat4_multiply_scalar(a[i], scalar).w.w;
+      }
+    }
+    double scalar_ms = time_now_ms() - scalar_start;
+
+    bench_sink = sink;
+
+    double ns = 1000000.0 / ((double)iterations * (double)count);
+    printf("  %22s %12.2f %12.2f %12.2f %12.2f %10lld\n", math_backend_name(backend), add_ms * ns, multiply_ms * ns, into_ms * ns, scalar_ms * ns, (long long)max_ulps);
+  }
+  math_backend_set(best_backend);
+}
+
+static float random_float(float lo, float hi)
+{
+  return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+static void print_batch(const char *name, int32_t count, double single_ms, double batched_ms, float max_error)
+{
+  printf("  %-18s %10d %12.4f %12.4f %9.2fx %12g\n", name, count, single_ms, batched_ms, single_ms / batched_ms, max_error);
+}
+
+/*
+ * times the array kernels of watt_math against calling the single value
+ * version per element, which for the soa kernels is a call with count 1 so
+ * it also checks the SIMD lanes against the scalar tail. every pass covers
+ * about BENCH_BATCH_ELEMENTS elements.
+ */
+#define BENCH_BATCH_ELEMENTS 1000000
+
+static void bench_batch(void)
+{
+  static const int32_t element_counts[] = {1000, 10000, 100000, 1000000};
+  int32_t max_count = element_counts[sizeof(element_counts) / sizeof(element_counts[0]) - 1];
+
+  struct mat4 *in = malloc((size_t)max_count * sizeof(struct mat4));
+  struct mat4 *single = malloc((size_t)max_count * sizeof(struct mat4));
+  struct mat4 *batched = malloc((size_t)max_count * sizeof(struct mat4));
+  struct affine3x4 *single_affine = malloc((size_t)max_count * sizeof(struct affine3x4));
+  struct affine3x4 *batched_affine = malloc((size_t)max_count * sizeof(struct affine3x4));
+  float *streams = malloc((size_t)max_count * 16 * sizeof(float));
+  assert(in && single && batched && single_affine && batched_affine && streams);
+  /*
+   * fault every output page in now, the largest count only runs one pass.
+   * not zero, the compiler would turn malloc + memset into a lazy calloc.
+   */
+  memset(single, 0xff, (size_t)max_count * sizeof(struct mat4));
+  memset(batched, 0xff, (size_t)max_count * sizeof(struct mat4));
+  memset(single_affine, 0xff, (size_t)max_count * sizeof(struct affine3x4));
+  memset(batched_affine, 0xff, (size_t)max_count * sizeof(struct affine3x4));
+  struct vec3_soa position = {streams, streams + max_count, streams + max_count * 2};
+  struct quat_soa rotation = {streams + max_count * 3, streams + max_count * 4, streams + max_count * 5, streams + max_count * 6};
+  struct vec3_soa scale = {streams + max_count * 7, streams + max_count * 8, streams + max_count * 9};
+  struct vec3_soa single_out = {streams + max_count * 10, streams + max_count * 11, streams + max_count * 12};
+  struct vec3_soa batched_out = {streams + max_count * 13, streams + max_count * 14, streams + max_count * 15};
+
+  srand(2);
+  for (int32_t i = 0; i < max_count; ++i) {
+    position.x[i] = random_float(-100.0f, 100.0f);
+    position.y[i] = random_float(-100.0f, 100.0f);
+    position.z[i] = random_float(-100.0f, 100.0f);
+    struct quat q = quat_axis_angle(vec3_normalize(v3(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(0.1f, 1.0f))), random_float(-WATT_PI32, WATT_PI32));
+    rotation.x[i] = q.x;
+    rotation.y[i] = q.y;
+    rotation.z[i] = q.z;
+    rotation.w[i] = q.w;
+    scale.x[i] = random_float(0.5f, 2.0f);
+    scale.y[i] = random_float(0.5f, 2.0f);
+    scale.z[i] = random_float(0.5f, 2.0f);
+    in[i] = mat4_compose_euler(v3(position.x[i], position.y[i], position.z[i]), v3(rotation.x[i], rotation.y[i], rotation.z[i]), v3(scale.x[i], scale.y[i], scale.z[i]));
+  }
+  struct mat4 view_proj = camera_view_proj();
+  struct quat q = quat_axis_angle(vec3_normalize(v3(1.0f, 2.0f, 3.0f)), 0.75f);
+
+  printf("batch %-15s %10s %12s %12s %10s %12s\n", "kernel", "elements", "single ms", "batched ms", "speedup", "max error");
+  for (int32_t n = 0; n < (int32_t)(sizeof(element_counts) / sizeof(element_counts[0])); ++n) {
+    int32_t count = element_counts[n];
+    int32_t passes = (BENCH_BATCH_ELEMENTS / count > 1) ? BENCH_BATCH_ELEMENTS / count : 1;
+
+    double start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      for (int32_t i = 0; i < count; ++i) {
+        single[i] = mat4_multiply(view_proj, in[i]);
+      }
+    }
+    double single_ms = (time_now_ms() - start) / (double)passes;
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      mat4_multiply_array(batched, view_proj, in, count);
+    }
+    double batched_ms = (time_now_ms() - start) / (double)passes;
+    print_batch("mat4_multiply", count, single_ms, batched_ms, max_difference(&single[0].x.x, &batched[0].x.x, (int64_t)count * 16));
+
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      for (int32_t i = 0; i < count; ++i) {
+        struct vec3 v = quat_rotate(v3(position.x[i], position.y[i], position.z[i]), q);
+        single_out.x[i] = v.x;
+        single_out.y[i] = v.y;
+        single_out.z[i] = v.z;
+      }
+    }
+    single_ms = (time_now_ms() - start) / (double)passes;
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      quat_rotate_soa(batched_out, position, q, count);
+    }
+    batched_ms = (time_now_ms() - start) / (double)passes;
+    print_batch("quat_rotate", count, single_ms, batched_ms, max_difference(single_out.x, batched_out.x, (int64_t)count * 3));
+
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      for (int32_t i = 0; i < count; ++i) {
+        struct vec3_soa p = {position.x + i, position.y + i, position.z + i};
+        struct vec3_soa out = {single_out.x + i, single_out.y + i, single_out.z + i};
+        vec3_transform_soa(out, view_proj, p, 1);
+      }
+    }
+    single_ms = (time_now_ms() - start) / (double)passes;
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      vec3_transform_soa(batched_out, view_proj, position, count);
+    }
+    batched_ms = (time_now_ms() - start) / (double)passes;
+    print_batch("vec3_transform", count, single_ms, batched_ms, max_difference(single_out.x, batched_out.x, (int64_t)count * 3));
+
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      for (int32_t i = 0; i < count; ++i) {
+        struct quat r = {rotation.x[i], rotation.y[i], rotation.z[i], rotation.w[i]};
+        single[i] = mat4_from_trs(v3(position.x[i], position.y[i], position.z[i]), r, v3(scale.x[i], scale.y[i], scale.z[i]));
+      }
+    }
+    single_ms = (time_now_ms() - start) / (double)passes;
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      mat4_compose_trs_soa(batched, position, rotation, scale, count);
+    }
+    batched_ms = (time_now_ms() - start) / (double)passes;
+    print_batch("compose_trs", count, single_ms, batched_ms, max_difference(&single[0].x.x, &batched[0].x.x, (int64_t)count * 16));
+
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      for (int32_t i = 0; i < count; ++i) {
+        struct quat r = {rotation.x[i], rotation.y[i], rotation.z[i], rotation.w[i]};
+        single_affine[i] = affine_from_trs(v3(position.x[i], position.y[i], position.z[i]), r, v3(scale.x[i], scale.y[i], scale.z[i]));
+      }
+    }
+    single_ms = (time_now_ms() - start) / (double)passes;
+    start = time_now_ms();
+    for (int32_t pass = 0; pass < passes; ++pass) {
+      affine_compose_trs_soa(batched_affine, position, rotation, scale, count);
+    }
+    batched_ms = (time_now_ms() - start) / (double)passes;
+    print_batch("compose_trs affine", count, single_ms, batched_ms, max_difference(&single_affine[0].x.x, &batched_affine[0].x.x, (int64_t)count * 12));
+  }
+
+  /* compose_trs has to agree with quat_rotate on what a rotation is, m * p = rotate(scale * p) + position */
+  float trs_error = 0.0f;
+  for (int32_t i = 0; i < max_count; i += 97) {
+    struct vec3 p = v3(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f));
+    struct vec3 expected = vec3_add(quat_rotate(v3(p.x * scale.x[i], p.y * scale.y[i], p.z * scale.z[i]), (struct quat){rotation.x[i], rotation.y[i], rotation.z[i], rotation.w[i]}), v3(position.x[i], position.y[i], position.z[i]));
+    struct mat4 m = batched[i];
+    trs_error = fmaxf(trs_error, fabsf(m.x.x * p.x + m.y.x * p.y + m.z.x * p.z + m.w.x - expected.x));
+    trs_error = fmaxf(trs_error, fabsf(m.x.y * p.x + m.y.y * p.y + m.z.y * p.z + m.w.y - expected.y));
+    trs_error = fmaxf(trs_error, fabsf(m.x.z * p.x + m.y.z * p.y + m.z.z * p.z + m.w.z - expected.z));
+  }
+  printf("  %-16s %12g\n", "trs vs quat", trs_error);
+
+  /* the affine kernels have to produce the top rows of the mat4 ones */
+  float affine_error = 0.0f;
+  for (int32_t i = 0; i < max_count; ++i) {
+    struct affine3x4 narrowed = affine_from_mat4(batched[i]);
+    affine_error = fmaxf(affine_error, max_difference(&narrowed.x.x, &batched_affine[i].x.x, 12));
+  }
+  printf("  %-16s %12g\n", "affine vs mat4", affine_error);
+
+  free(in);
+  free(single);
+  free(batched);
+  free(single_affine);
+  free(batched_affine);
+  free(streams);
+}
+
+/*
+ * times affine_multiply against mat4_multiply on the same transforms and
+ * checks multiply, inverse and normal transform against their mat4 and
+ * geometric definitions
+ */
+static void bench_affine(int32_t iterations)
+{
+  enum { count = 1024 };
+  static struct affine3x4 a[count], b[count], affine_result[count];
+  static struct mat4 ma[count], mb[count], mat4_result[count];
+
+  srand(3);
+  for (int32_t i = 0; i < count; ++i) {
+    struct quat qa = quat_axis_angle(vec3_normalize(v3(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(0.1f, 1.0f))), random_float(-WATT_PI32, WATT_PI32));
+    struct quat qb = quat_axis_angle(vec3_normalize(v3(random_float(0.1f, 1.0f), random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f))), random_float(-WATT_PI32, WATT_PI32));
+    a[i] = affine_from_trs(v3(random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f)), qa, v3(random_float(0.5f, 2.0f), random_float(0.5f, 2.0f), random_float(0.5f, 2.0f)));
+    b[i] = affine_from_trs(v3(random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f)), qb, v3(random_float(0.5f, 2.0f), random_float(0.5f, 2.0f), random_float(0.5f, 2.0f)));
+    ma[i] = affine_to_mat4(a[i]);
+    mb[i] = affine_to_mat4(b[i]);
+  }
+
+  double start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    for (int32_t i = 0; i < count; ++i) {
+      mat4_result[i] = mat4_multiply(ma[i], mb[i]);
+    }
+    bench_sink = mat4_result[n % count].w.x;
+  }
+  double mat4_ms = time_now_ms() - start;
+  start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    for (int32_t i = 0; i < count; ++i) {
+      affine_result[i] = affine_multiply(a[i], b[i]);
+    }
+    bench_sink = affine_result[n % count].x.w;
+  }
+  double affine_ms = time_now_ms() - start;
+
+  float multiply_error = 0.0f;
+  float inverse_error = 0.0f;
+  float normal_error = 0.0f;
+  struct mat4 identity = mat4_identity();
+  for (int32_t i = 0; i < count; ++i) {
+    struct mat4 widened = affine_to_mat4(affine_result[i]);
+    multiply_error = fmaxf(multiply_error, max_difference(&widened.x.x, &mat4_result[i].x.x, 16));
+
+    struct mat4 round_trip = affine_to_mat4(affine_multiply(affine_inverse(a[i]), a[i]));
+    inverse_error = fmaxf(inverse_error, max_difference(&round_trip.x.x, &identity.x.x, 16));
+
+    /* a normal has to stay perpendicular to a tangent of its surface */
+    struct vec3 normal = vec3_normalize(v3(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(0.1f, 1.0f)));
+    struct vec3 tangent = vec3_normalize(vec3_cross(normal, v3(1.0f, 0.0f, 0.0f)));
+    struct vec3 origin = affine_transform_point(a[i], v3(0.0f, 0.0f, 0.0f));
+    struct vec3 world_tangent = vec3_normalize(vec3_add(affine_transform_point(a[i], tangent), vec3_scale(origin, -1.0f)));
+    normal_error = fmaxf(normal_error, fabsf(vec3_dot(affine_transform_normal(a[i], normal), world_tangent)));
+  }
+  if (multiply_error > 1e-3f || inverse_error > 1e-3f || normal_error > 1e-4f) {
+    printf("affine: results differ, multiply %g inverse %g normal %g\n", multiply_error, inverse_error, normal_error);
+    exit(1);
+  }
+
+  double ns = 1000000.0 / ((double)iterations * (double)count);
+  printf("affine %17s %12s %10s\n", "mat4 ns", "affine ns", "speedup");
+  printf("  %-16s %12.2f %12.2f %9.2fx\n", "multiply", mat4_ms * ns, affine_ms * ns, mat4_ms / affine_ms);
+  printf("  %-16s %12g\n", "multiply error", multiply_error);
+  printf("  %-16s %12g\n", "inverse error", inverse_error);
+  printf("  %-16s %12g\n", "normal error", normal_error);
+}
+
+/* gauss-jordan with partial pivoting in double, the reference for the float inverses */
+static void mat4_inverse_reference(const struct mat4 *m, double *out)
+{
+  double rows[4][8];
+  for (int32_t r = 0; r < 4; ++r) {
+    for (int32_t c = 0; c < 4; ++c) {
+      rows[r][c] = (&m->x.x)[c * 4 + r];
+      rows[r][c + 4] = (r == c) ? 1.0 : 0.0;
+    }
+  }
+  for (int32_t c = 0; c < 4; ++c) {
+    int32_t pivot = c;
+    for (int32_t r = c + 1; r < 4; ++r) {
+      pivot = (fabs(rows[r][c]) > fabs(rows[pivot][c])) ? r : pivot;
+    }
+    for (int32_t k = 0; k < 8; ++k) {
+      double tmp = rows[c][k];
+      rows[c][k] = rows[pivot][k];
+      rows[pivot][k] = tmp;
+    }
+    double inv_pivot = 1.0 / rows[c][c];
+    for (int32_t k = 0; k < 8; ++k) {
+      rows[c][k] *= inv_pivot;
+    }
+    for (int32_t r = 0; r < 4; ++r) {
+      double f = rows[r][c];
+      for (int32_t k = 0; r != c && k < 8; ++k) {
+        rows[r][k] -= f * rows[c][k];
+      }
+    }
+  }
+  for (int32_t r = 0; r < 4; ++r) {
+    for (int32_t c = 0; c < 4; ++c) {
+      out[c * 4 + r] = rows[r][c + 4];
+    }
+  }
+}
+
+/* largest element error against the reference, relative to the reference's largest element */
+static double inverse_error(const struct mat4 *got, const double *expected)
+{
+  double max_error = 0.0;
+  double magnitude = 1.0;
+  for (int32_t k = 0; k < 16; ++k) {
+    max_error = fmax(max_error, fabs((double)(&got->x.x)[k] - expected[k]));
+    magnitude = fmax(magnitude, fabs(expected[k]));
+  }
+  return max_error / magnitude;
+}
+
+/*
+ * times mat4_inverse on every backend against the affine and rigid
+ * specializations, checks all of them against a double precision
+ * reference, and round trips points through camera_view_proj and unproject
+ */
+static void bench_inverse(int32_t iterations)
+{
+  enum { count = 1024 };
+  static struct mat4 general[count], affine[count], rigid[count], result[count];
+  static struct affine3x4 affine_narrow[count], rigid_narrow[count], affine_result[count];
+  static double reference[3][count][16];
+  const double tolerance = 1e-5;
+
+  srand(4);
+  for (int32_t i = 0; i < count; ++i) {
+    /* diagonally weighted so the random matrices stay well conditioned */
+    float *g = &general[i].x.x;
+    for (int32_t k = 0; k < 16; ++k) {
+      g[k] = random_float(-1.0f, 1.0f) + ((k % 5 == 0) ? 3.0f : 0.0f);
+    }
+    struct quat q = quat_axis_angle(vec3_normalize(v3(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(0.1f, 1.0f))), random_float(-WATT_PI32, WATT_PI32));
+    struct vec3 position = v3(random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f), random_float(-100.0f, 100.0f));
+    affine_narrow[i] = affine_from_trs(position, q, v3(random_float(0.5f, 2.0f), random_float(0.5f, 2.0f), random_float(0.5f, 2.0f)));
+    rigid_narrow[i] = affine_from_trs(position, q, v3(1.0f, 1.0f, 1.0f));
+    affine[i] = affine_to_mat4(affine_narrow[i]);
+    rigid[i] = affine_to_mat4(rigid_narrow[i]);
+    mat4_inverse_reference(&general[i], reference[0][i]);
+    mat4_inverse_reference(&affine[i], reference[1][i]);
+    mat4_inverse_reference(&rigid[i], reference[2][i]);
+  }
+
+  printf("inverse%24s %12s\n", "ns", "max error");
+  int32_t best_backend = math_backend();
+  for (int32_t backend = 0; backend < MATH_BACKEND_COUNT; ++backend) {
+    if (!math_backend_set(backend)) {
+      continue;
+    }
+    double max_error = 0.0;
+    for (int32_t i = 0; i < count; ++i) {
+      struct mat4 by_value = mat4_inverse(general[i]);
+      mat4_inverse_into(&result[i], &general[i]);
+      if (memcmp(&by_value, &result[i], sizeof(struct mat4)) != 0) {
+        printf("inverse: %s by value and into results differ\n", math_backend_name(backend));
+        exit(1);
+      }
+      max_error = fmax(max_error, inverse_error(&result[i], reference[0][i]));
+    }
+    if (max_error > tolerance) {
+      printf("inverse: %s off by %g\n", math_backend_name(backend), max_error);
+      exit(1);
+    }
+
+    double start = time_now_ms();
+    for (int32_t n = 0; n < iterations; ++n) {
+      for (int32_t i = 0; i < count; ++i) {
+        mat4_inverse_into(&result[i], &general[i]);
+      }
+      bench_sink = result[n % count].x.x;
+    }
+    double ms = time_now_ms() - start;
+    printf("  mat4 %-11s %12.2f %12g\n", math_backend_name(backend), ms * 1000000.0 / ((double)iterations * (double)count), max_error);
+  }
+  math_backend_set(best_backend);
+
+  double affine_error = 0.0;
+  double rigid_error = 0.0;
+  for (int32_t i = 0; i < count; ++i) {
+    struct mat4 widened = affine_to_mat4(affine_inverse(affine_narrow[i]));
+    affine_error = fmax(affine_error, inverse_error(&widened, reference[1][i]));
+    widened = affine_to_mat4(affine_inverse_rigid(rigid_narrow[i]));
+    rigid_error = fmax(rigid_error, inverse_error(&widened, reference[2][i]));
+  }
+  if (affine_error > tolerance || rigid_error > tolerance) {
+    printf("inverse: affine off by %g, rigid off by %g\n", affine_error, rigid_error);
+    exit(1);
+  }
+
+  double start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    for (int32_t i = 0; i < count; ++i) {
+      affine_result[i] = affine_inverse(affine_narrow[i]);
+    }
+    bench_sink = affine_result[n % count].x.x;
+  }
+  double affine_ms = time_now_ms() - start;
+  start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    for (int32_t i = 0; i < count; ++i) {
+      affine_result[i] = affine_inverse_rigid(rigid_narrow[i]);
+    }
+    bench_sink = affine_result[n % count].x.x;
+  }
+  double rigid_ms = time_now_ms() - start;
+  double ns = 1000000.0 / ((double)iterations * (double)count);
+  printf("  %-16s %12.2f %12g\n", "affine", affine_ms * ns, affine_error);
+  printf("  %-16s %12.2f %12g\n", "rigid", rigid_ms * ns, rigid_error);
+
+  /*
+   * unproject against the same ndc taken through the double reference
+   * inverse. with a 0.01 - 1000 depth range the clip w of a far point is
+   * the difference of two nearly equal floats, a few 1e-4 of the view
+   * distance is as close as float gets there.
+   */
+  struct mat4 view_proj = camera_view_proj();
+  struct mat4 inv_view_proj = mat4_inverse(view_proj);
+  double inv_reference[16];
+  mat4_inverse_reference(&view_proj, inv_reference);
+  float unproject_error = 0.0f;
+  float ray_error = 0.0f;
+  for (int32_t i = 0; i < count; ++i) {
+    struct vec3 p = v3(random_float(-50.0f, 50.0f), random_float(-10.0f, 10.0f), random_float(-50.0f, 50.0f));
+    struct mat4 m = view_proj;
+    float w = m.x.w * p.x + m.y.w * p.y + m.z.w * p.z + m.w.w;
+    if (w < 1.0f) {
+      continue;
+    }
+    struct vec2 ndc = v2((m.x.x * p.x + m.y.x * p.y + m.z.x * p.z + m.w.x) / w, (m.x.y * p.x + m.y.y * p.y + m.z.y * p.z + m.w.y) / w);
+    float depth = (m.x.z * p.x + m.y.z * p.y + m.z.z * p.z + m.w.z) / w;
+    double clip[4];
+    for (int32_t k = 0; k < 4; ++k) {
+      clip[k] = inv_reference[k] * ndc.x + inv_reference[4 + k] * ndc.y + inv_reference[8 + k] * depth + inv_reference[12 + k];
+    }
+    struct vec3 expected = v3((float)(clip[0] / clip[3]), (float)(clip[1] / clip[3]), (float)(clip[2] / clip[3]));
+    struct vec3 back = unproject(ndc, depth, inv_view_proj);
+    unproject_error = fmaxf(unproject_error, vec3_length(vec3_add(back, vec3_scale(expected, -1.0f))) / w);
+
+    /* the ray has to pass through the expected point */
+    struct ray ray = unproject_ray(ndc, inv_view_proj);
+    struct vec3 to_expected = vec3_add(expected, vec3_scale(ray.origin, -1.0f));
+    ray_error = fmaxf(ray_error, vec3_length(vec3_cross(to_expected, ray.direction)) / w);
+  }
+  if (unproject_error > 2e-3f || ray_error > 2e-3f) {
+    printf("unproject: off by %g, ray off by %g\n", unproject_error, ray_error);
+    exit(1);
+  }
+
+  start = time_now_ms();
+  for (int32_t n = 0; n < iterations; ++n) {
+    for (int32_t i = 0; i < count; ++i) {
+      struct ray ray = unproject_ray(v2((float)i / (float)count * 2.0f - 1.0f, 0.25f), inv_view_proj);
+      bench_sink = ray.direction.x;
+    }
+  }
+  double ray_ms = time_now_ms() - start;
+  printf("  %-16s %12.2f %12g\n", "unproject_ray", ray_ms * ns, ray_error);
+  printf("  %-16s %12s %12g\n", "unproject", "", unproject_error);
+}
+
+/*
+ * times a linear frustum_cull_soa pass against bvh_cull over synthetic towns
+ * of growing size, with the camera of frame()
+ */
+static void bench_culling(int32_t iterations)
+{
+  static const int32_t entity_counts[] = {1000, 10000, 100000};
+  struct frustum frustum = frustum_from_mat4(camera_view_proj());
+
+  printf("culling %16s %12s %12s %12s %10s\n", "entities", "linear ms", "bvh ms", "build ms", "visible");
+  for (int32_t n = 0; n < (int32_t)(sizeof(entity_counts) / sizeof(entity_counts[0])); ++n) {
+    int32_t count = entity_counts[n];
+    spawn_entities(count);
+    update_entity_transforms();
+
+    double build_start = time_now_ms();
+    if (!update_entity_bvh()) {
+      fprintf(stderr, "culling: could not build the bvh over %d entities\n", count);
+      exit(1);
+    }
+    double build_ms = time_now_ms() - build_start;
+
+    int32_t linear_visible = 0;
+    double linear_start = time_now_ms();
+    for (int32_t i = 0; i < iterations; ++i) {
+      linear_visible = frustum_cull_soa(entity_transforms.visible, frustum, entity_transforms.world_center, entity_transforms.world_extent, count);
+    }
+    double linear_ms = (time_now_ms() - linear_start) / (double)iterations;
+
+    int32_t bvh_visible = 0;
+    double bvh_start = time_now_ms();
+    for (int32_t i = 0; i < iterations; ++i) {
+      bvh_visible = bvh_cull(&entity_bvh, entity_transforms.visible_next, frustum, entity_transforms.world_center, entity_transforms.world_extent);
+    }
+    double bvh_ms = (time_now_ms() - bvh_start) / (double)iterations;
+
+    if (linear_visible != bvh_visible || memcmp(entity_transforms.visible, entity_transforms.visible_next, (size_t)count) != 0) {
+      fprintf(stderr, "culling: bvh sees %d of %d entities, linear %d\n", bvh_visible, count, linear_visible);
+      exit(1);
+    }
+    printf("  %22d %12.4f %12.4f %12.3f %10d\n", count, linear_ms, bvh_ms, build_ms, bvh_visible);
+  }
+}
+
+/*
+ * removes every other entity of a grid of count, after turning one in eight
+ * so some are dirty when they are removed or moved, and times it. then checks that the
+ * removed handles are dead, that the live ones still address their own
+ * transform streams, and that the dirty list, the bvh and the asset
+ * references followed the moves.
+ */
+static void bench_remove(int32_t count)
+{
+  struct quat turn = quat_axis_angle(v3(0.0f, 1.0f, 0.0f), WATT_RAD_FROM_DEG(10.0f));
+  struct frustum frustum = frustum_from_mat4(camera_view_proj());
+
+  spawn_entities(count);
+  update_entity_transforms();
+  if (!update_entity_bvh()) {
+    fprintf(stderr, "remove: could not build the bvh over %d entities\n", count);
+    exit(1);
+  }
+
+  uint32_t *ids = malloc((size_t)count * sizeof(uint32_t));
+  struct vec3 *positions = malloc((size_t)count * sizeof(struct vec3));
+  struct quat *rotations = malloc((size_t)count * sizeof(struct quat));
+  int32_t *ref_counts = malloc((size_t)asset_count * sizeof(int32_t));
+  if (!ids || !positions || !rotations || !ref_counts) {
+    fprintf(stderr, "remove: out of memory for %d entities\n", count);
+    exit(1);
+  }
+  for (int32_t i = 0; i < count; ++i) {
+    if (i % 16 < 2) {
+      entity_turn((uint32_t)i, turn);
+    }
+    ids[i] = pool_item_id(&entity_pool, (uint32_t)i);
+    positions[i] = v3(entity_transforms.position.x[i], entity_transforms.position.y[i], entity_transforms.position.z[i]);
+    rotations[i] = entity_rotation((uint32_t)i);
+  }
+  for (int32_t i = 0; i < asset_count; ++i) {
+    ref_counts[i] = assets[i].ref_count;
+  }
+  for (int32_t i = 0; i < count; i += 2) {
+    --ref_counts[((struct entity *)pool_get(&entity_pool, ids[i]))->asset_idx];
+  }
+
+  double start = time_now_ms();
+  for (int32_t i = 0; i < count; i += 2) {
+    entity_remove(ids[i]);
+  }
+  double remove_ms = time_now_ms() - start;
+
+  int32_t removed = (count + 1) / 2;
+  if ((int32_t)entity_pool.count != count - removed) {
+    fprintf(stderr, "remove: %u entities left instead of %d\n", entity_pool.count, count - removed);
+    exit(1);
+  }
+  for (int32_t i = 0; i < count; ++i) {
+    uint32_t index = pool_index(&entity_pool, ids[i]);
+    if (i % 2 == 0) {
+      if (index != POOL_INVALID_INDEX) {
+        fprintf(stderr, "remove: removed entity %u still has index %u\n", ids[i], index);
+        exit(1);
+      }
+      continue;
+    }
+    if (index == POOL_INVALID_INDEX || pool_item_id(&entity_pool, index) != ids[i]) {
+      fprintf(stderr, "remove: entity %u lost its handle\n", ids[i]);
+      exit(1);
+    }
+    struct quat rotation = entity_rotation(index);
+    if (entity_transforms.position.x[index] != positions[i].x || entity_transforms.position.y[index] != positions[i].y || entity_transforms.position.z[index] != positions[i].z
+      || memcmp(&rotation, &rotations[i], sizeof(rotation)) != 0) {
+      fprintf(stderr, "remove: entity %u lost its transform\n", ids[i]);
+      exit(1);
+    }
+  }
+  for (int32_t i = 0; i < asset_count; ++i) {
+    if (assets[i].ref_count != ref_counts[i]) {
+      fprintf(stderr, "remove: asset %d has %d references instead of %d\n", i, assets[i].ref_count, ref_counts[i]);
+      exit(1);
+    }
+  }
+
+  /* every moved dirty entity must still be on the dirty list */
+  update_entity_transforms();
+  float model_error = 0.0f;
+  for (uint32_t i = 0; i < entity_pool.count; ++i) {
+    struct affine3x4 expected = affine_from_trs(
+      v3(entity_transforms.position.x[i], entity_transforms.position.y[i], entity_transforms.position.z[i]),
+      entity_rotation(i),
+      v3(entity_transforms.scale.x[i], entity_transforms.scale.y[i], entity_transforms.scale.z[i]));
+    model_error = fmaxf(model_error, max_difference(&expected.x.x, &entity_transforms.model[i].x.x, 12));
+    if (entity_transforms.dirty[i]) {
+      fprintf(stderr, "remove: entity %u is still dirty\n", pool_item_id(&entity_pool, i));
+      exit(1);
+    }
+  }
+  if (model_error > 1e-5f) {
+    fprintf(stderr, "remove: stale models, off by %g\n", model_error);
+    exit(1);
+  }
+
+  int32_t live_count = (int32_t)entity_pool.count;
+  if (!update_entity_bvh()) {
+    fprintf(stderr, "remove: could not rebuild the bvh over %d entities\n", live_count);
+    exit(1);
+  }
+  int32_t linear_visible = frustum_cull_soa(entity_transforms.visible, frustum, entity_transforms.world_center, entity_transforms.world_extent, live_count);
+  int32_t bvh_visible = bvh_cull(&entity_bvh, entity_transforms.visible_next, frustum, entity_transforms.world_center, entity_transforms.world_extent);
+  if (linear_visible != bvh_visible || memcmp(entity_transforms.visible, entity_transforms.visible_next, (size_t)live_count) != 0) {
+    fprintf(stderr, "remove: bvh sees %d of %d entities, linear %d\n", bvh_visible, live_count, linear_visible);
+    exit(1);
+  }
+
+  printf("remove (%d of %d entities)\n", removed, count);
+  printf("  %-16s %12.3f ms\n", "time", remove_ms);
+  printf("  %-16s %12.1f ns\n", "per entity", remove_ms * 1000000.0 / (double)removed);
+  printf("  %-16s %12g\n", "model error", model_error);
+
+  free(ref_counts);
+  free(rotations);
+  free(positions);
+  free(ids);
+}
+
+/*
+ * times cgltf's byte at a time base64 decoder against base64_decode over
+ * the data uris of every gltf file in assets/
+ */
+static void bench_base64(int32_t iterations)
+{
+  double cgltf_ms = 0.0;
+  double watt_ms = 0.0;
+  int64_t decoded_bytes = 0;
+  int32_t file_count = 0;
+
+  DIR *dir = opendir("assets");
+  if (!dir) {
+    fprintf(stderr, "base64: could not open assets/\n");
+    exit(1);
+  }
+  for (struct dirent *entry = readdir(dir); entry; entry = readdir(dir)) {
+    const char *extension = strrchr(entry->d_name, '.');
+    if (!extension || strcmp(extension, ".gltf") != 0) {
+      continue;
+    }
+    char filename[512];
+    snprintf(filename, sizeof(filename), "assets/%s", entry->d_name);
+    struct buffer file = buffer_create_from_file(filename);
+    if (file.size == 0) {
+      fprintf(stderr, "base64: could not read %s\n", filename);
+      exit(1);
+    }
+
+    cgltf_options options = {0};
+    cgltf_data *gltf = NULL;
+    if (cgltf_parse(&options, file.data, file.size, &gltf) != cgltf_result_success) {
+      fprintf(stderr, "base64: could not parse %s\n", filename);
+      exit(1);
+    }
+
+    for (cgltf_size i = 0; i < gltf->buffers_count; ++i) {
+      const char *uri = gltf->buffers[i].uri;
+      const char *comma = uri ? strchr(uri, ',') : NULL;
+      if (!comma || strncmp(uri, "data:", 5) != 0) {
+        continue;
+      }
+      size_t size = gltf->buffers[i].size;
+      uint8_t *decoded = malloc(size);
+      if (!decoded) {
+        fprintf(stderr, "base64: out of memory for %zu bytes\n", size);
+        exit(1);
+      }
+
+      void *reference = NULL;
+      double cgltf_start = time_now_ms();
+      for (int32_t j = 0; j < iterations; ++j) {
+        free(reference);
+        if (cgltf_load_buffer_base64(&options, size, comma + 1, &reference) != cgltf_result_success) {
+          fprintf(stderr, "base64: cgltf could not decode buffer %zu of %s\n", (size_t)i, filename);
+          exit(1);
+        }
+      }
+      cgltf_ms += time_now_ms() - cgltf_start;
+
+      double watt_start = time_now_ms();
+      for (int32_t j = 0; j < iterations; ++j) {
+        if (!base64_decode(decoded, size, comma + 1)) {
+          fprintf(stderr, "base64: base64_decode rejected buffer %zu of %s\n", (size_t)i, filename);
+          exit(1);
+        }
+      }
+      watt_ms += time_now_ms() - watt_start;
+
+      if (memcmp(reference, decoded, size) != 0) {
+        fprintf(stderr, "base64: base64_decode differs from cgltf for buffer %zu of %s\n", (size_t)i, filename);
+        exit(1);
+      }
+      decoded_bytes += (int64_t)size;
+      free(reference);
+      free(decoded);
+    }
+
+    cgltf_free(gltf);
+    buffer_destroy(&file);
+    ++file_count;
+  }
+  closedir(dir);
+
+  double megabytes = (double)decoded_bytes * (double)iterations / (1024.0 * 1024.0);
+  printf("base64 decode (%d files, %lld bytes, %s)\n", file_count, (long long)decoded_bytes, base64_decoder_name());
+  printf("  %-16s %12.3f ms %10.1f MB/s\n", "cgltf", cgltf_ms / (double)iterations, megabytes / (cgltf_ms / 1000.0));
+  printf("  %-16s %12.3f ms %10.1f MB/s\n", "base64_decode", watt_ms / (double)iterations, megabytes / (watt_ms / 1000.0));
+  printf("  %-16s %12.2fx\n", "speedup", cgltf_ms / watt_ms);
+}
+
+static void prepare_job(void *data, int32_t worker)
+{
+  mesh_file_load_prepare(data, &load_arenas[worker]);
+}
+
+/*
+ * times preparing (reading, parsing and decoding) a directory of file_count
+ * gltf files, copies of the ones in assets/, with growing numbers of
+ * loader workers. 0 workers prepares on the main thread.
+ */
+static void bench_startup(int32_t file_count)
+{
+  struct buffer sources[16];
+  int32_t source_count = 0;
+  DIR *assets_dir = opendir("assets");
+  if (!assets_dir) {
+    fprintf(stderr, "startup: could not open assets/\n");
+    exit(1);
+  }
+  for (struct dirent *entry = readdir(assets_dir); entry && source_count < 16; entry = readdir(assets_dir)) {
+    const char *extension = strrchr(entry->d_name, '.');
+    if (extension && strcmp(extension, ".gltf") == 0) {
+      char filename[512];
+      snprintf(filename, sizeof(filename), "assets/%s", entry->d_name);
+      sources[source_count++] = buffer_create_from_file(filename);
+    }
+  }
+  closedir(assets_dir);
+  if (source_count == 0) {
+    fprintf(stderr, "startup: no gltf files in assets/\n");
+    exit(1);
+  }
+
+  char dir[] = "/tmp/bench_assets_XXXXXX";
+  if (!mkdtemp(dir)) {
+    fprintf(stderr, "startup: could not create %s: %s\n", dir, strerror(errno));
+    exit(1);
+  }
+  char (*filenames)[64] = calloc((size_t)file_count, sizeof(*filenames));
+  const char **filename_list = calloc((size_t)file_count, sizeof(const char *));
+  struct mesh_file_load *loads = calloc((size_t)file_count, sizeof(struct mesh_file_load));
+  if (!filenames || !filename_list || !loads) {
+    fprintf(stderr, "startup: out of memory for %d files\n", file_count);
+    exit(1);
+  }
+  for (int32_t i = 0; i < file_count; ++i) {
+    snprintf(filenames[i], sizeof(filenames[i]), "%s/asset_%04d.gltf", dir, i);
+    filename_list[i] = filenames[i];
+    FILE *file = fopen(filenames[i], "wb");
+    if (!file) {
+      fprintf(stderr, "startup: could not create %s: %s\n", filenames[i], strerror(errno));
+      exit(1);
+    }
+    size_t written = fwrite(sources[i % source_count].data, 1, (size_t)sources[i % source_count].size, file);
+    if (fclose(file) != 0 || written != (size_t)sources[i % source_count].size) {
+      fprintf(stderr, "startup: could not write %s\n", filenames[i]);
+      exit(1);
+    }
+  }
+
+  int32_t cpu_count = jobs_cpu_count();
+  double serial_ms = 0.0;
+  printf("startup (%d gltf files, %d cpus)\n", file_count, cpu_count);
+  printf("  %-16s %12s %10s %12s %12s\n", "workers", "prepare ms", "speedup", "allocs/file", "arena/file");
+  for (int32_t workers = 0; workers <= cpu_count; workers = (workers == 0) ? 1 : workers * 2) {
+    struct jobs bench_jobs;
+    if (!jobs_create(&bench_jobs, workers)) {
+      fprintf(stderr, "startup: could not start %d workers\n", workers);
+      exit(1);
+    }
+    memset(loads, 0, (size_t)file_count * sizeof(struct mesh_file_load));
+
+    int64_t arena_pushes = 0;
+    for (int32_t i = 0; i < JOBS_MAX_THREADS + 1; ++i) {
+      arena_pushes -= (int64_t)load_arenas[i].push_count;
+    }
+    int64_t allocs = counters.allocs;
+
+    int saved_stdout = stdout_silence();
+    double start = time_now_ms();
+    for (int32_t i = 0; i < file_count; ++i) {
+      loads[i].filename = filename_list[i];
+      jobs_push(&bench_jobs, prepare_job, &loads[i]);
+    }
+    jobs_wait(&bench_jobs);
+    double prepare_ms = time_now_ms() - start;
+    stdout_restore(saved_stdout);
+    allocs = counters.allocs - allocs;
+    for (int32_t i = 0; i < JOBS_MAX_THREADS + 1; ++i) {
+      arena_pushes += (int64_t)load_arenas[i].push_count;
+    }
+
+    for (int32_t i = 0; i < file_count; ++i) {
+      if (loads[i].failed || !loads[i].data_decoded) {
+        fprintf(stderr, "startup: %s did not decode\n", loads[i].filename);
+        exit(1);
+      }
+      mesh_file_load_discard(&loads[i]);
+    }
+    jobs_destroy(&bench_jobs);
+
+    serial_ms = (workers == 0) ? prepare_ms : serial_ms;
+    printf("  %-16d %12.3f %9.2fx %12.1f %12.1f\n", workers, prepare_ms, serial_ms / prepare_ms, (double)allocs / (double)file_count, (double)arena_pushes / (double)file_count);
+  }
+
+  for (int32_t i = 0; i < file_count; ++i) {
+    unlink(filenames[i]);
+  }
+  rmdir(dir);
+  for (int32_t i = 0; i < source_count; ++i) {
+    buffer_destroy(&sources[i]);
+  }
+  free(loads);
+  free(filename_list);
+  free(filenames);
+}
+
+static void move_entities(int32_t count)
+{
+  struct quat turn = quat_axis_angle(v3(0.0f, 0.0f, 1.0f), WATT_RAD_FROM_DEG(1.0f));
+  for (int32_t i = 0, ilen = (int32_t)entity_pool.count; i < count && i < ilen; ++i) {
+    entity_turn((uint32_t)i, turn);
+  }
+}
+
+static void print_per_frame(const char *name, int64_t count, int32_t frames)
+{
+  printf("  %-16s %12.1f\n", name, (double)count / (double)frames);
+}
+
+int main(int argc, char *argv[])
+{
+  int32_t bench_entity_count = (argc > 1) ? atoi(argv[1]) : BENCH_DEFAULT_ENTITY_COUNT;
+  int32_t bench_frame_count = (argc > 2) ? atoi(argv[2]) : BENCH_DEFAULT_FRAME_COUNT;
+  int32_t bench_moving_count = (argc > 3) ? atoi(argv[3]) : BENCH_DEFAULT_MOVING_COUNT;
+  assert(bench_entity_count > 0 && bench_frame_count > 0 && bench_moving_count >= 0);
+
+  int saved_stdout = stdout_silence();
+
+  setup_gfx();
+  jobs_create(&job_system, jobs_cpu_count());
+  sg_install_trace_hooks(&(sg_trace_hooks){
+    .make_buffer = trace_make_buffer,
+    .init_buffer = trace_init_buffer,
+    .make_pipeline = trace_make_pipeline,
+    .update_buffer = trace_update_buffer,
+    .append_buffer = trace_append_buffer,
+    .apply_pipeline = trace_apply_pipeline,
+    .apply_bindings = trace_apply_bindings,
+    .apply_uniforms = trace_apply_uniforms,
+    .draw = trace_draw,
+  });
+
+  /* the first frame runs while the scene is still streaming in */
+  double load_start = time_now_ms();
+  load_scene();
+  frame();
+  double first_frame_ms = time_now_ms() - load_start;
+  finish_streaming();
+  double load_ms = time_now_ms() - load_start;
+  struct bench_counters load_counters = counters;
+  uint64_t load_arena_pushes = 0;
+  uint64_t load_arena_overflows = 0;
+  uint64_t load_arena_peak = 0;
+  for (int32_t i = 0; i < JOBS_MAX_THREADS + 1; ++i) {
+    load_arena_pushes += load_arenas[i].push_count;
+    load_arena_overflows += load_arenas[i].overflow_push_count;
+    load_arena_peak = (load_arenas[i].peak > load_arena_peak) ? load_arenas[i].peak : load_arena_peak;
+  }
+
+  spawn_entities(bench_entity_count);
+
+  for (int32_t i = 0; i < BENCH_WARMUP_FRAME_COUNT; ++i) {
+    frame();
+  }
+  stdout_restore(saved_stdout);
+
+  double *frame_ms = calloc((size_t)bench_frame_count, sizeof(double));
+  assert(frame_ms);
+
+  counters = (struct bench_counters){0};
+  uint64_t frame_arena_pushes = frame_arena.push_count;
+  uint64_t frame_arena_bytes = frame_arena.push_bytes;
+  uint64_t frame_arena_overflows = frame_arena.overflow_push_count;
+  double total_ms = 0.0;
+  for (int32_t i = 0; i < bench_frame_count; ++i) {
+    move_entities(bench_moving_count);
+    double frame_start = time_now_ms();
+    frame();
+    frame_ms[i] = time_now_ms() - frame_start;
+    counters.drawn_entities += drawn_entity_count;
+    counters.culled_entities += culled_entity_count;
+    total_ms += frame_ms[i];
+  }
+  struct bench_counters frame_counters = counters;
+  frame_arena_pushes = frame_arena.push_count - frame_arena_pushes;
+  frame_arena_bytes = frame_arena.push_bytes - frame_arena_bytes;
+  frame_arena_overflows = frame_arena.overflow_push_count - frame_arena_overflows;
+
+  qsort(frame_ms, (size_t)bench_frame_count, sizeof(double), compare_double);
+
+  printf("bench: %d entities (%d moving), %d meshes, %d submeshes, %d frames\n", (int32_t)entity_pool.count, bench_moving_count, mesh_count, submesh_count, bench_frame_count);
+  printf("load\n");
+  printf("  %-16s %12.3f ms\n", "first frame", first_frame_ms);
+  printf("  %-16s %12.3f ms\n", "time", load_ms);
+  printf("  %-16s %12lld\n", "make_buffer", (long long)load_counters.make_buffer);
+  printf("  %-16s %12lld\n", "buffer bytes", (long long)load_counters.buffer_bytes);
+  printf("  %-16s %12lld\n", "make_pipeline", (long long)load_counters.make_pipeline);
+  printf("  %-16s %12lld\n", "allocs", (long long)load_counters.allocs);
+  printf("  %-16s %12lld\n", "alloc bytes", (long long)load_counters.alloc_bytes);
+  printf("  %-16s %12llu\n", "arena pushes", (unsigned long long)load_arena_pushes);
+  printf("  %-16s %12llu\n", "arena overflows", (unsigned long long)load_arena_overflows);
+  printf("  %-16s %12llu\n", "arena peak", (unsigned long long)load_arena_peak);
+  printf("frame cpu time\n");
+  printf("  %-16s %12.3f ms\n", "mean", total_ms / (double)bench_frame_count);
+  printf("  %-16s %12.3f ms\n", "p50", frame_ms[bench_frame_count / 2]);
+  printf("  %-16s %12.3f ms\n", "p99", frame_ms[(bench_frame_count * 99) / 100]);
+  printf("  %-16s %12.3f ms\n", "max", frame_ms[bench_frame_count - 1]);
+  printf("per frame\n");
+  print_per_frame("apply_pipeline", frame_counters.apply_pipeline, bench_frame_count);
+  print_per_frame("apply_bindings", frame_counters.apply_bindings, bench_frame_count);
+  print_per_frame("apply_uniforms", frame_counters.apply_uniforms, bench_frame_count);
+  print_per_frame("update_buffer", frame_counters.update_buffer, bench_frame_count);
+  print_per_frame("append_buffer", frame_counters.append_buffer, bench_frame_count);
+  print_per_frame("state changes", frame_counters.apply_pipeline + frame_counters.apply_bindings, bench_frame_count);
+  print_per_frame("draw", frame_counters.draw, bench_frame_count);
+  print_per_frame("instances", frame_counters.instances, bench_frame_count);
+  print_per_frame("drawn entities", frame_counters.drawn_entities, bench_frame_count);
+  print_per_frame("culled entities", frame_counters.culled_entities, bench_frame_count);
+  print_per_frame("allocs", frame_counters.allocs, bench_frame_count);
+  print_per_frame("alloc bytes", frame_counters.alloc_bytes, bench_frame_count);
+  print_per_frame("arena pushes", (int64_t)frame_arena_pushes, bench_frame_count);
+  print_per_frame("arena bytes", (int64_t)frame_arena_bytes, bench_frame_count);
+  print_per_frame("arena overflows", (int64_t)frame_arena_overflows, bench_frame_count);
+
+  bench_transforms(bench_frame_count);
+  bench_math(bench_frame_count);
+  bench_batch();
+  bench_affine(bench_frame_count);
+  bench_inverse(bench_frame_count);
+  bench_culling(bench_frame_count);
+  bench_remove(bench_entity_count);
+  bench_base64(bench_frame_count);
+  bench_startup(BENCH_STARTUP_FILE_COUNT);
+
+  free(frame_ms);
+  cleanup();
+  return 0;
+}
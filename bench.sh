@@ -0,0 +1,24 @@
+#!/bin/sh
+
+set -eu
+
+mkdir -p ./dist
+
+gcc cook.c watt_math.c watt_base64.c watt_buffer.c watt_mesh.c \
+  -O2 \
+  -lm \
+  -lpthread \
+  -o ./dist/cook
+
+./dist/cook assets/*.gltf > /dev/null
+
+gcc bench.c watt_math.c watt_base64.c watt_buffer.c watt_bvh.c watt_input.c watt_jobs.c watt_mesh.c watt_pool.c watt_sort.c \
+  -O2 \
+  -march=native \
+  -DNDEBUG \
+  -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=posix_memalign \
+  -lm \
+  -lpthread \
+  -o ./dist/bench
+
+./dist/bench "$@"
@@ -11,7 +11,12 @@ if [ `command -v clang-format -h` ]; then
   mv demo.c.tmp demo.c
 fi
 
-gcc demo.c watt_math.c watt_buffer.c watt_input.c \
+gcc cook.c watt_math.c watt_base64.c watt_buffer.c watt_mesh.c \
+  -o ./dist/cook
+
+./dist/cook assets/*.gltf
+
+gcc demo.c watt_math.c watt_base64.c watt_buffer.c watt_bvh.c watt_input.c watt_jobs.c watt_mesh.c watt_pool.c watt_sort.c \
   -DSOKOL_METAL=1 \
   -o ./dist/demo \
   -ObjC \
@@ -22,7 +27,7 @@ gcc demo.c watt_math.c watt_buffer.c watt_input.c \
   -framework MetalKit \
   -framework AudioToolbox
 
-emcc demo.c watt_math.c watt_buffer.c watt_input.c \
+emcc demo.c watt_math.c watt_base64.c watt_buffer.c watt_bvh.c watt_input.c watt_jobs.c watt_mesh.c watt_pool.c watt_sort.c \
   -DSOKOL_GLES2=1 \
   -O2 \
   -Os \
@@ -33,4 +38,8 @@ emcc demo.c watt_math.c watt_buffer.c watt_input.c \
   --preload-file assets/toob.gltf \
   --preload-file assets/plus.gltf \
   --preload-file assets/reggie.gltf \
-  --preload-file assets/rolo.gltf
+  --preload-file assets/rolo.gltf \
+  --preload-file assets/toob.pack \
+  --preload-file assets/plus.pack \
+  --preload-file assets/reggie.pack \
+  --preload-file assets/rolo.pack
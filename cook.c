@@ -0,0 +1,45 @@
+/*
+ * offline asset cooker
+ *
+ * converts gltf files into mesh packs (see struct mesh_pack_header in
+ * watt_mesh.h), which the demo maps and uploads without parsing json or
+ * decoding base64 at startup
+ *
+ * usage: cook file.gltf... writes file.pack next to every input
+ */
+
+#include "watt_buffer.h"
+#include "watt_mesh.h"
+
+#include <stdio.h> /* printf */
+
+int main(int argc, char **argv)
+{
+  struct buffer_arena arena;
+  buffer_arena_create(&arena, 0);
+  int32_t failed = 0;
+  for (int32_t i = 1; i < argc; ++i) {
+    char pack_filename[256];
+    if (!mesh_pack_filename(pack_filename, sizeof(pack_filename), argv[i])) {
+      printf("cook: path too long %s\n", argv[i]);
+      failed = 1;
+      continue;
+    }
+
+    struct mesh_data data;
+    if (!mesh_data_load_gltf(argv[i], &data, &arena)) {
+      printf("cook: cannot read %s\n", argv[i]);
+      failed = 1;
+      continue;
+    }
+    if (!mesh_pack_write(pack_filename, &data)) {
+      printf("cook: cannot write %s\n", pack_filename);
+      failed = 1;
+    } else {
+      printf("cook: %s -> %s (%d meshes, %d vertices, %d indices)\n", argv[i], pack_filename, data.mesh_count, data.vertex_count, data.index_count);
+    }
+    mesh_data_free(&data);
+  }
+  buffer_arena_destroy(&arena);
+  return failed;
+}
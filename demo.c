@@ -1,293 +1,1311 @@
-#define CGLTF_IMPLEMENTATION
-#include "cgltf.h"
-
 #include "watt_buffer.h"
+#include "watt_bvh.h"
 #include "watt_input.h"
+#include "watt_jobs.h"
 #include "watt_math.h"
+#include "watt_mesh.h"
+#include "watt_pool.h"
+#include "watt_sort.h"
 
 #include <assert.h>
 #include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #define SOKOL_IMPL
+#if defined(DEMO_HEADLESS)
+/* headless builds (see bench.c) render through the sokol_gfx dummy backend */
+#define SOKOL_DUMMY_BACKEND
+#include "sokol_gfx.h"
+#else
 #include "sokol_app.h"
 #include "sokol_gfx.h"
+#endif
 
 #include "demo.glsl.h"
 
 #define SAMPLE_COUNT 4
 
-#define MAX_BUFFER_COUNT 64
-#define MAX_SUBMESH_COUNT 32
-#define MAX_MESH_COUNT 16
-#define MAX_ENTITY_COUNT 16
+#define DISPLAY_WIDTH 800
+#define DISPLAY_HEIGHT 600
+
+#define INITIAL_SUBMESH_CAPACITY 32
+#define INITIAL_MESH_CAPACITY 16
+#define INITIAL_ENTITY_CAPACITY 16
+#define STREAM_ALIGNMENT 32
 
+#define CAMERA_FOV WATT_RAD_FROM_DEG(60.0f)
+#define CAMERA_Z_NEAR 0.01f
+#define CAMERA_Z_FAR 1000.0f
+
+/*
+ * buffer and pipeline storage is sized from the sokol_gfx pool sizes in setup_gfx.
+ * buffers[0, buffer_count) are slots in use or freed, a freed slot has an invalid id.
+ */
 static int32_t buffer_count = 0;
-static sg_buffer buffers[MAX_BUFFER_COUNT];
+static int32_t buffer_capacity = 0;
+static sg_buffer *buffers = 0;
 
 static int32_t pipeline_count = 0;
-static sg_pipeline pipelines[MAX_SUBMESH_COUNT];
+static int32_t pipeline_capacity = 0;
+static sg_pipeline *pipelines = 0;
+static sg_pipeline_desc *pipeline_descs = 0;
+static uint64_t *pipeline_hashes = 0;
+
+/* open addressing table of pipeline_idx + 1, 0 marks an empty slot */
+static uint32_t pipeline_cache_size = 0; /* power of two, > pipeline_capacity */
+static int32_t *pipeline_cache = 0;
 
 struct submesh {
-  int32_t buffer_indices[4]; // pos, normal, uv, indices
-  int32_t buffer_offsets[4]; // pos, normal, uv, indices
+  int32_t vertex_buffer_idx; // struct packed_vertex, shared by all submeshes of a file
+  int32_t index_buffer_idx;
+  int32_t base_element; // first index in the shared index buffer
   int32_t element_count;
   int32_t pipeline_idx;
+  struct aabb bounds; // object space
 };
 
 static int32_t submesh_count = 0;
-static struct submesh submeshes[MAX_SUBMESH_COUNT];
+static int32_t submesh_capacity = 0;
+static struct submesh *submeshes = 0;
 
 struct mesh {
   int32_t submesh_start_idx;
   int32_t submesh_end_idx;
+  int32_t instance_start; // first instances entry this frame
+  int32_t instance_count;
+  struct aabb bounds; // union of the submesh bounds
+  /* undo the quantization of struct packed_vertex, copied into every instance of the mesh */
+  struct vec4 position_scale;
+  struct vec4 position_offset;
+  struct vec4 texcoord_transform; // xy scale, zw offset
 };
 
 static int32_t mesh_count = 0;
-static struct mesh meshes[MAX_MESH_COUNT];
+static int32_t mesh_capacity = 0;
+static struct mesh *meshes = 0;
+
+/*
+ * a loaded file, found by its path while streaming in and by its content
+ * hash once ready. its meshes are the range [mesh_start, mesh_start +
+ * mesh_count) of meshes, which moves as other assets are freed. references
+ * are held by load_mesh_file_async callers and by the entities using it.
+ */
+#define ASSET_LOADING 0
+#define ASSET_READY 1
+#define ASSET_FAILED 2
+
+struct asset {
+  uint64_t path_hash;
+  uint64_t content_hash;
+  int32_t state;
+  int32_t mesh_start; // -1 until ready
+  int32_t mesh_count;
+  int32_t vertex_buffer_idx;
+  int32_t index_buffer_idx;
+  int32_t source_idx; // asset whose meshes and buffers are shared, or -1
+  int32_t ref_count;
+  int32_t ready_pending; // became ready during this update_streaming
+};
+
+static int32_t asset_count = 0;
+static int32_t asset_capacity = 0;
+static struct asset *assets = 0;
+
+/* file loading workers, zeroed (loading on the main thread) until init() */
+static struct jobs job_system;
 
 struct entity {
-  int32_t mesh_idx;
-  struct vec3 position;
-  struct vec3 rotation;
-  struct vec3 scale;
+  int32_t asset_idx;
+  int32_t mesh; // index into the meshes of the asset
+};
+
+/* world bounds of entities whose asset is still streaming in, so they can be picked */
+static const struct aabb entity_placeholder_bounds = {{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}};
+
+/*
+ * transform streams (structure of arrays), element i belongs to the entity
+ * at dense index i of entity_pool. every stream is STREAM_ALIGNMENT aligned.
+ */
+struct entity_transforms {
+  struct vec3_soa position;
+  struct quat_soa rotation; // unit quaternions
+  struct vec3_soa scale;
+  struct affine3x4 *model;  // world matrices composed from the above
+  uint8_t *dirty;           // model is stale, see entity_mark_dirty
+  int32_t *instance_index;  // where model is copied in instances, -1 when culled
+  struct vec3_soa world_center; // world space bounds of the mesh under model
+  struct vec3_soa world_extent;
+  uint8_t *visible;         // inside the view frustum last frame
+  uint8_t *visible_next;    // scratch for the cull pass
+};
+
+/* every stream of struct entity_transforms with its element size, for bulk grow/free/move */
+struct entity_stream {
+  void **data;
+  size_t item_size;
+};
+
+#define ENTITY_STREAM_FLOAT(field) {(void **)&entity_transforms.field, sizeof(float)}
+static struct entity_transforms entity_transforms;
+static const struct entity_stream entity_streams[] = {
+  ENTITY_STREAM_FLOAT(position.x),
+  ENTITY_STREAM_FLOAT(position.y),
+  ENTITY_STREAM_FLOAT(position.z),
+  ENTITY_STREAM_FLOAT(rotation.x),
+  ENTITY_STREAM_FLOAT(rotation.y),
+  ENTITY_STREAM_FLOAT(rotation.z),
+  ENTITY_STREAM_FLOAT(rotation.w),
+  ENTITY_STREAM_FLOAT(scale.x),
+  ENTITY_STREAM_FLOAT(scale.y),
+  ENTITY_STREAM_FLOAT(scale.z),
+  ENTITY_STREAM_FLOAT(world_center.x),
+  ENTITY_STREAM_FLOAT(world_center.y),
+  ENTITY_STREAM_FLOAT(world_center.z),
+  ENTITY_STREAM_FLOAT(world_extent.x),
+  ENTITY_STREAM_FLOAT(world_extent.y),
+  ENTITY_STREAM_FLOAT(world_extent.z),
+  {(void **)&entity_transforms.model, sizeof(struct affine3x4)},
+  {(void **)&entity_transforms.dirty, sizeof(uint8_t)},
+  {(void **)&entity_transforms.instance_index, sizeof(int32_t)},
+  {(void **)&entity_transforms.visible, sizeof(uint8_t)},
+  {(void **)&entity_transforms.visible_next, sizeof(uint8_t)},
+};
+#define ENTITY_STREAM_COUNT (int32_t)(sizeof(entity_streams) / sizeof(entity_streams[0]))
+
+/* densely packed struct entity items, addressed by stable pool ids */
+static struct pool entity_pool;
+static int32_t entity_transform_capacity = 0;
+static uint32_t player_entity_id = POOL_INVALID_ID;
+
+/* indices with a dirty flag set, may hold duplicates and removed indices */
+static int32_t dirty_entity_count = 0;
+static int32_t dirty_entity_capacity = 0;
+static int32_t *dirty_entities = 0;
+
+/*
+ * everything a draw needs per instance, so a frame's draws only differ in
+ * their bindings and apply vs_params once per pipeline. model has the
+ * mesh's position dequantization folded in.
+ */
+struct instance {
+  struct affine3x4 model;
+  struct vec4 texcoord_transform;
+};
+
+/*
+ * instances grouped by mesh. the grouping is only redone when entities are
+ * added or removed, and instance_buffer is only updated, with one upload
+ * for the whole frame, when a model matrix changed.
+ */
+static int32_t instance_capacity = 0;
+static struct instance *instances = 0;
+static sg_buffer instance_buffer;
+static int32_t instance_layout_dirty = 1;
+static int32_t instance_data_dirty = 1;
+
+/*
+ * render queue, one draw per submesh of every mesh with visible instances.
+ * draw_keys sort by pipeline, then position buffer, then depth front to back
+ * and carry the draws index in their low bits.
+ */
+#define DRAW_KEY_PIPELINE_SHIFT 52 // 12 bits
+#define DRAW_KEY_BUFFER_SHIFT 36   // 16 bits
+#define DRAW_KEY_DEPTH_SHIFT 16    // 20 bits
+#define DRAW_KEY_DEPTH_MAX 0xfffff
+#define DRAW_KEY_INDEX_MASK 0xffff
+#define DRAW_KEY_MAX_PIPELINES (1 << (64 - DRAW_KEY_PIPELINE_SHIFT))
+#define DRAW_KEY_MAX_BUFFERS (1 << (DRAW_KEY_PIPELINE_SHIFT - DRAW_KEY_BUFFER_SHIFT))
+
+_Static_assert(((uint64_t)DRAW_KEY_DEPTH_MAX << DRAW_KEY_DEPTH_SHIFT) < ((uint64_t)1 << DRAW_KEY_BUFFER_SHIFT), "depth overlaps the buffer field");
+_Static_assert(DRAW_KEY_INDEX_MASK < (1 << DRAW_KEY_DEPTH_SHIFT), "draw index overlaps the depth field");
+
+struct draw {
+  int32_t submesh_idx;
+  int32_t instance_start;
+  int32_t instance_count;
 };
 
-static int32_t entity_count = 0;
-static struct entity entities[MAX_ENTITY_COUNT];
+static int32_t draw_count = 0;
+static struct draw *draws = 0;          // frame_arena
+static uint64_t *draw_keys = 0;         // frame_arena
+static uint64_t *draw_keys_scratch = 0; // frame_arena
+
+/*
+ * scratch memory. frame_arena is reset at the top of every frame and holds
+ * whatever is only needed until the frame is submitted. load_arenas hold
+ * the staging of one file being decoded, one per job_system worker plus
+ * one for loads run inline, and are reset after each file. once they have
+ * grown to their high-water mark neither touches the heap again.
+ */
+#define FRAME_ARENA_CAPACITY (64 * 1024)
+
+static struct buffer_arena frame_arena;
+static struct buffer_arena load_arenas[JOBS_MAX_THREADS + 1];
+
+/*
+ * bvh over the entity world bounds, items are dense entity indices. moved
+ * entities are refit, adding or removing entities rebuilds it. below
+ * ENTITY_BVH_MIN_COUNT entities a linear pass over the bounds streams beats
+ * walking the tree (about 5k entities in the culling bench, before paying
+ * for builds), so the bvh is neither built nor used and stays dirty.
+ */
+#define ENTITY_BVH_MIN_COUNT 8192
+
+static struct bvh entity_bvh;
+static int32_t entity_bvh_dirty = 1;
+
+/* frustum culling results of the last frame */
+static int32_t drawn_entity_count = 0;
+static int32_t instanced_entity_count = 0; // drawn entities whose asset is ready
+static int32_t culled_entity_count = 0;
+
+static struct vec3 camera_position = {0.0f, 50.0f, 50.0f};
+static struct vec3 camera_target = {0.0f, 0.0f, 0.0f};
 
 static sg_shader shader;
 static struct input input_state = {0};
 
-static int32_t gltf_attr_type_to_vs_input_slot(cgltf_attribute_type attr_type)
+static int32_t display_width(void)
 {
-  switch (attr_type) {
-  case cgltf_attribute_type_position:
-    return ATTR_vs_position;
-  case cgltf_attribute_type_normal:
-    return ATTR_vs_normal;
-  case cgltf_attribute_type_texcoord:
-    return ATTR_vs_texcoord;
-  default:
-    return -1;
+#if defined(DEMO_HEADLESS)
+  return DISPLAY_WIDTH;
+#else
+  return sapp_width();
+#endif
+}
+
+static int32_t display_height(void)
+{
+#if defined(DEMO_HEADLESS)
+  return DISPLAY_HEIGHT;
+#else
+  return sapp_height();
+#endif
+}
+
+static const sg_shader_desc *shader_desc(void)
+{
+#if defined(SOKOL_DUMMY_BACKEND)
+  /* sokol-shdc has no dummy target, the dummy backend only validates uniform block sizes */
+  static const sg_shader_desc dummy_desc = {
+    .vs.uniform_blocks[SLOT_vs_params].size = sizeof(vs_params_t),
+    .label = "demo_shader",
+  };
+  return &dummy_desc;
+#else
+  return demo_shader_desc();
+#endif
+}
+
+/* grows a heap array to fit count items by doubling its capacity */
+static void *reserve_items(void *items, int32_t *capacity, int32_t count, size_t item_size)
+{
+  if (count <= *capacity) {
+    return items;
+  }
+  int32_t new_capacity = (*capacity > 0) ? *capacity : 1;
+  while (new_capacity < count) {
+    new_capacity *= 2;
+  }
+  items = realloc(items, (size_t)new_capacity * item_size);
+  assert(items);
+  *capacity = new_capacity;
+  return items;
+}
+
+static void reserve_instances(int32_t count)
+{
+  if (count <= instance_capacity) {
+    return;
+  }
+  instances = reserve_items(instances, &instance_capacity, count, sizeof(struct instance));
+
+  if (instance_buffer.id != SG_INVALID_ID) {
+    sg_destroy_buffer(instance_buffer);
   }
+  instance_buffer = sg_make_buffer(&(sg_buffer_desc){
+    .type = SG_BUFFERTYPE_VERTEXBUFFER,
+    .usage = SG_USAGE_DYNAMIC,
+    .size = instance_capacity * (int32_t)sizeof(struct instance),
+    .label = "instances",
+  });
+  instance_data_dirty = 1;
 }
 
-static sg_vertex_format gltf_to_vertex_format(cgltf_accessor *acc)
+/*
+ * like reserve_items but keeps the array STREAM_ALIGNMENT aligned for SIMD loads.
+ * returns 0 and leaves items untouched when the allocation fails, like realloc
+ */
+static void *reserve_aligned_items(void *items, int32_t count, int32_t new_capacity, size_t item_size)
 {
-  switch (acc->component_type) {
-  case cgltf_component_type_r_8:
-    if (acc->type == cgltf_type_vec4) {
-      return acc->normalized ? SG_VERTEXFORMAT_BYTE4N : SG_VERTEXFORMAT_BYTE4;
+  void *new_items = 0;
+  if (posix_memalign(&new_items, STREAM_ALIGNMENT, (size_t)new_capacity * item_size) != 0) {
+    return 0;
+  }
+  if (items) {
+    memcpy(new_items, items, (size_t)count * item_size);
+    free(items);
+  }
+  return new_items;
+}
+
+/* returns 0 when a stream could not grow, the streams then keep their old capacity */
+static int32_t reserve_entity_transforms(int32_t count)
+{
+  if (count <= entity_transform_capacity) {
+    return 1;
+  }
+  int32_t new_capacity = (entity_transform_capacity > 0) ? entity_transform_capacity : 1;
+  while (new_capacity < count) {
+    new_capacity *= 2;
+  }
+
+  /* entity_add grows the pool before the streams, so count can exceed the old capacity */
+  int32_t used = (int32_t)entity_pool.count < entity_transform_capacity ? (int32_t)entity_pool.count : entity_transform_capacity;
+  for (int32_t i = 0; i < ENTITY_STREAM_COUNT; ++i) {
+    void *data = reserve_aligned_items(*entity_streams[i].data, used, new_capacity, entity_streams[i].item_size);
+    if (!data) {
+      /* streams grown so far stay valid, they are only larger than entity_transform_capacity */
+      return 0;
     }
-    break;
-  case cgltf_component_type_r_8u:
-    if (acc->type == cgltf_type_vec4) {
-      return acc->normalized ? SG_VERTEXFORMAT_UBYTE4N : SG_VERTEXFORMAT_UBYTE4;
+    *entity_streams[i].data = data;
+  }
+  entity_transform_capacity = new_capacity;
+  return 1;
+}
+
+static void free_entity_transforms(void)
+{
+  for (int32_t i = 0; i < ENTITY_STREAM_COUNT; ++i) {
+    free(*entity_streams[i].data);
+  }
+  memset(&entity_transforms, 0, sizeof(entity_transforms));
+  entity_transform_capacity = 0;
+
+  free(dirty_entities);
+  dirty_entities = 0;
+  dirty_entity_count = 0;
+  dirty_entity_capacity = 0;
+}
+
+/* call after changing any transform stream of the entity at index */
+static void entity_mark_dirty(uint32_t index)
+{
+  if (entity_transforms.dirty[index]) {
+    return;
+  }
+  entity_transforms.dirty[index] = 1;
+  dirty_entities = reserve_items(dirty_entities, &dirty_entity_capacity, dirty_entity_count + 1, sizeof(int32_t));
+  dirty_entities[dirty_entity_count++] = (int32_t)index;
+}
+
+static struct quat entity_rotation(uint32_t index)
+{
+  return (struct quat){
+    entity_transforms.rotation.x[index],
+    entity_transforms.rotation.y[index],
+    entity_transforms.rotation.z[index],
+    entity_transforms.rotation.w[index],
+  };
+}
+
+/* applies turn in the entity's local frame, renormalized so repeated turns don't drift */
+static void entity_turn(uint32_t index, struct quat turn)
+{
+  struct quat rotation = quat_normalize(quat_multiply(entity_rotation(index), turn));
+  entity_transforms.rotation.x[index] = rotation.x;
+  entity_transforms.rotation.y[index] = rotation.y;
+  entity_transforms.rotation.z[index] = rotation.z;
+  entity_transforms.rotation.w[index] = rotation.w;
+  entity_mark_dirty(index);
+}
+
+/* allocates a buffer in the first free slot of buffers, returns the slot or -1 when the pool is full */
+static int32_t buffer_slot_alloc(void)
+{
+  int32_t slot = 0;
+  while (slot < buffer_count && buffers[slot].id != SG_INVALID_ID) {
+    ++slot;
+  }
+  if (slot == buffer_capacity) {
+    return -1;
+  }
+  sg_buffer buffer = sg_alloc_buffer();
+  if (buffer.id == SG_INVALID_ID) {
+    return -1;
+  }
+  buffers[slot] = buffer;
+  buffer_count = (slot == buffer_count) ? buffer_count + 1 : buffer_count;
+  return slot;
+}
+
+/* destroys the buffer of a slot so buffer_slot_alloc can hand it out again, -1 is ignored */
+static void buffer_slot_free(int32_t slot)
+{
+  if (slot < 0) {
+    return;
+  }
+  sg_destroy_buffer(buffers[slot]);
+  buffers[slot] = (sg_buffer){0};
+}
+
+/*
+ * removes meshes [start, start + count) and their submeshes, which are
+ * contiguous since upload_mesh_data appends both. later meshes, submeshes
+ * and asset ranges move down; assets inside the range are left without
+ * meshes.
+ */
+static void meshes_remove(int32_t start, int32_t count)
+{
+  if (count == 0) {
+    return;
+  }
+  int32_t end = start + count;
+  int32_t submesh_start = meshes[start].submesh_start_idx;
+  int32_t submesh_removed = meshes[end - 1].submesh_end_idx - submesh_start;
+  memmove(submeshes + submesh_start, submeshes + submesh_start + submesh_removed, (size_t)(submesh_count - submesh_start - submesh_removed) * sizeof(struct submesh));
+  submesh_count -= submesh_removed;
+  memmove(meshes + start, meshes + end, (size_t)(mesh_count - end) * sizeof(struct mesh));
+  mesh_count -= count;
+  for (int32_t i = start; i < mesh_count; ++i) {
+    meshes[i].submesh_start_idx -= submesh_removed;
+    meshes[i].submesh_end_idx -= submesh_removed;
+  }
+  for (int32_t i = 0; i < asset_count; ++i) {
+    if (assets[i].mesh_start >= end) {
+      assets[i].mesh_start -= count;
+    } else if (assets[i].mesh_start >= start) {
+      assets[i].mesh_start = -1;
+      assets[i].mesh_count = 0;
     }
-    break;
-  case cgltf_component_type_r_16:
-    switch (acc->type) {
-    case cgltf_type_vec2:
-      return acc->normalized ? SG_VERTEXFORMAT_SHORT2N : SG_VERTEXFORMAT_SHORT2;
-    case cgltf_type_vec4:
-      return acc->normalized ? SG_VERTEXFORMAT_SHORT4N : SG_VERTEXFORMAT_SHORT4;
-    default:
-      break;
+  }
+  instance_layout_dirty = 1;
+}
+
+/*
+ * drops one reference. the last one frees the asset's buffer slots and
+ * removes its meshes.
+ */
+static void asset_release(int32_t asset_idx)
+{
+  struct asset *asset = &assets[asset_idx];
+  assert(asset->ref_count > 0);
+  if (--asset->ref_count > 0) {
+    return;
+  }
+  if (asset->state == ASSET_LOADING) {
+    /* update_streaming drops it once prepared */
+    return;
+  }
+  if (asset->source_idx >= 0) {
+    asset_release(asset->source_idx);
+    return;
+  }
+  buffer_slot_free(asset->vertex_buffer_idx);
+  buffer_slot_free(asset->index_buffer_idx);
+  asset->vertex_buffer_idx = -1;
+  asset->index_buffer_idx = -1;
+  if (asset->mesh_start >= 0) {
+    meshes_remove(asset->mesh_start, asset->mesh_count);
+  }
+}
+
+/* mesh of an entity, or 0 while its asset is not ready */
+static struct mesh *entity_mesh(const struct entity *entity)
+{
+  const struct asset *asset = &assets[entity->asset_idx];
+  if (asset->state != ASSET_READY || entity->mesh >= asset->mesh_count) {
+    return 0;
+  }
+  return &meshes[asset->mesh_start + entity->mesh];
+}
+
+/* returns POOL_INVALID_ID when the pool or the transform streams could not grow */
+static uint32_t entity_add(int32_t asset_idx, int32_t mesh, struct vec3 position, struct quat rotation, struct vec3 scale)
+{
+  uint32_t entity_id = pool_add(&entity_pool);
+  if (entity_id == POOL_INVALID_ID) {
+    return POOL_INVALID_ID;
+  }
+  if (!reserve_entity_transforms((int32_t)entity_pool.count)) {
+    pool_remove(&entity_pool, entity_id);
+    return POOL_INVALID_ID;
+  }
+  uint32_t index = pool_index(&entity_pool, entity_id);
+
+  struct entity *entity = pool_item(&entity_pool, index);
+  entity->asset_idx = asset_idx;
+  entity->mesh = mesh;
+  ++assets[asset_idx].ref_count;
+  entity_transforms.position.x[index] = position.x;
+  entity_transforms.position.y[index] = position.y;
+  entity_transforms.position.z[index] = position.z;
+  entity_transforms.rotation.x[index] = rotation.x;
+  entity_transforms.rotation.y[index] = rotation.y;
+  entity_transforms.rotation.z[index] = rotation.z;
+  entity_transforms.rotation.w[index] = rotation.w;
+  entity_transforms.scale.x[index] = scale.x;
+  entity_transforms.scale.y[index] = scale.y;
+  entity_transforms.scale.z[index] = scale.z;
+  entity_transforms.dirty[index] = 0;
+  entity_transforms.visible[index] = 0;
+  entity_transforms.instance_index[index] = -1;
+  entity_mark_dirty(index);
+  instance_layout_dirty = 1;
+  entity_bvh_dirty = 1;
+  return entity_id;
+}
+
+static void entity_remove(uint32_t entity_id)
+{
+  uint32_t index = pool_index(&entity_pool, entity_id);
+  assert(index != POOL_INVALID_INDEX);
+  asset_release(((struct entity *)pool_item(&entity_pool, index))->asset_idx);
+  pool_remove(&entity_pool, entity_id);
+  instance_layout_dirty = 1;
+  entity_bvh_dirty = 1;
+
+  /* the pool moved its last item into the hole, mirror that in the streams */
+  uint32_t last = entity_pool.count;
+  if (index != last) {
+    uint8_t last_dirty = entity_transforms.dirty[last];
+    for (int32_t i = 0; i < ENTITY_STREAM_COUNT; ++i) {
+      size_t item_size = entity_streams[i].item_size;
+      uint8_t *data = *entity_streams[i].data;
+      memcpy(data + index * item_size, data + last * item_size, item_size);
     }
-    break;
-  case cgltf_component_type_r_32f:
-    switch (acc->type) {
-    case cgltf_type_scalar:
-      return SG_VERTEXFORMAT_FLOAT;
-    case cgltf_type_vec2:
-      return SG_VERTEXFORMAT_FLOAT2;
-    case cgltf_type_vec3:
-      return SG_VERTEXFORMAT_FLOAT3;
-    case cgltf_type_vec4:
-      return SG_VERTEXFORMAT_FLOAT4;
-    default:
-      break;
+    entity_transforms.dirty[index] = 0;
+    if (last_dirty) {
+      entity_mark_dirty(index);
     }
-    break;
-  default:
-    break;
   }
-  return SG_VERTEXFORMAT_INVALID;
 }
 
-static sg_index_type gltf_to_index_type(const cgltf_primitive *prim)
+/* removes every entity at once, releasing their asset references */
+static void entity_clear(void)
 {
-  if (prim->indices) {
-    if (prim->indices->component_type == cgltf_component_type_r_16u) {
-      return SG_INDEXTYPE_UINT16;
-    } else {
-      return SG_INDEXTYPE_UINT32;
+  for (uint32_t i = 0; i < entity_pool.count; ++i) {
+    asset_release(((struct entity *)pool_item(&entity_pool, i))->asset_idx);
+  }
+  pool_clear(&entity_pool);
+  dirty_entity_count = 0;
+  instance_layout_dirty = 1;
+  entity_bvh_dirty = 1;
+}
+
+/* world bounds follow the model matrix, call after recomposing it */
+static void update_entity_bounds(int32_t index)
+{
+  const struct mesh *mesh = entity_mesh(pool_item(&entity_pool, (uint32_t)index));
+  struct aabb bounds = aabb_transform_affine(mesh ? mesh->bounds : entity_placeholder_bounds, entity_transforms.model[index]);
+  entity_transforms.world_center.x[index] = (bounds.min.x + bounds.max.x) * 0.5f;
+  entity_transforms.world_center.y[index] = (bounds.min.y + bounds.max.y) * 0.5f;
+  entity_transforms.world_center.z[index] = (bounds.min.z + bounds.max.z) * 0.5f;
+  entity_transforms.world_extent.x[index] = (bounds.max.x - bounds.min.x) * 0.5f;
+  entity_transforms.world_extent.y[index] = (bounds.max.y - bounds.min.y) * 0.5f;
+  entity_transforms.world_extent.z[index] = (bounds.max.z - bounds.min.z) * 0.5f;
+}
+
+/* model * the mesh's position dequantization (scale, then offset), without a full matrix multiply */
+static struct instance mesh_instance(const struct mesh *mesh, struct affine3x4 model)
+{
+  struct vec4 scale = mesh->position_scale;
+  struct vec4 offset = mesh->position_offset;
+  return (struct instance){
+    .model = {
+      .x = v4(model.x.x * scale.x, model.x.y * scale.y, model.x.z * scale.z, model.x.x * offset.x + model.x.y * offset.y + model.x.z * offset.z + model.x.w),
+      .y = v4(model.y.x * scale.x, model.y.y * scale.y, model.y.z * scale.z, model.y.x * offset.x + model.y.y * offset.y + model.y.z * offset.z + model.y.w),
+      .z = v4(model.z.x * scale.x, model.z.y * scale.y, model.z.z * scale.z, model.z.x * offset.x + model.z.y * offset.y + model.z.z * offset.z + model.z.w),
+    },
+    .texcoord_transform = mesh->texcoord_transform,
+  };
+}
+
+/* recomposes the model matrix and world bounds of every dirty entity */
+static void update_entity_transforms(void)
+{
+  struct entity *entities = entity_pool.items;
+  int32_t entity_count = (int32_t)entity_pool.count;
+  if (dirty_entity_count == 0) {
+    return;
+  }
+
+  if (dirty_entity_count * 2 >= entity_count) {
+    /* mostly dirty, e.g. after spawning, the batched kernel wins */
+    affine_compose_trs_soa(entity_transforms.model, entity_transforms.position, entity_transforms.rotation, entity_transforms.scale, entity_count);
+    memset(entity_transforms.dirty, 0, (size_t)entity_count);
+    for (int32_t i = 0, ilen = entity_count; i < ilen; ++i) {
+      update_entity_bounds(i);
+    }
+    if (!entity_bvh_dirty) {
+      bvh_refit(&entity_bvh, entity_transforms.world_center, entity_transforms.world_extent);
+    }
+    for (int32_t i = 0, ilen = instance_layout_dirty ? 0 : entity_count; i < ilen; ++i) {
+      int32_t instance_index = entity_transforms.instance_index[i];
+      if (instance_index >= 0) {
+        instances[instance_index] = mesh_instance(entity_mesh(&entities[i]), entity_transforms.model[i]);
+      }
     }
   } else {
-    return SG_INDEXTYPE_NONE;
+    for (int32_t i = 0, ilen = dirty_entity_count; i < ilen; ++i) {
+      int32_t index = dirty_entities[i];
+      if (index >= entity_count || !entity_transforms.dirty[index]) {
+        continue;
+      }
+      entity_transforms.model[index] = affine_from_trs(
+        v3(entity_transforms.position.x[index], entity_transforms.position.y[index], entity_transforms.position.z[index]),
+        entity_rotation(index),
+        v3(entity_transforms.scale.x[index], entity_transforms.scale.y[index], entity_transforms.scale.z[index]));
+      entity_transforms.dirty[index] = 0;
+      update_entity_bounds(index);
+      if (!entity_bvh_dirty) {
+        bvh_refit_item(&entity_bvh, index, entity_transforms.world_center, entity_transforms.world_extent);
+      }
+      int32_t instance_index = entity_transforms.instance_index[index];
+      if (!instance_layout_dirty && instance_index >= 0) {
+        instances[instance_index] = mesh_instance(entity_mesh(&entities[index]), entity_transforms.model[index]);
+      }
+    }
   }
+  dirty_entity_count = 0;
+  instance_data_dirty = 1;
 }
 
-static void load_gltf_meshes(cgltf_data *gltf, int32_t buffer_base_idx)
+/* returns 0 when the bvh could not be built, it then stays dirty and is retried next frame */
+static int32_t update_entity_bvh(void)
 {
-  assert(gltf->meshes);
-
-  printf("load_gltf_meshes\n");
+  if (!entity_bvh_dirty) {
+    return 1;
+  }
+  if (!bvh_build(&entity_bvh, entity_transforms.world_center, entity_transforms.world_extent, (int32_t)entity_pool.count)) {
+    return 0;
+  }
+  entity_bvh_dirty = 0;
+  return 1;
+}
 
-  for (int32_t i = 0, ilen = gltf->meshes_count; i < ilen; ++i) {
-    struct mesh *mesh = &meshes[mesh_count++];
-    assert(mesh_count < MAX_MESH_COUNT);
+/*
+ * tests the entity world bounds against the view frustum through the bvh, or
+ * linearly for few entities or when it could not be built. a culled entity
+ * gets no instance, so visibility changes regroup the instances.
+ */
+static void cull_entities(struct mat4 view_proj)
+{
+  int32_t entity_count = (int32_t)entity_pool.count;
+  struct frustum frustum = frustum_from_mat4(view_proj);
 
-    mesh->submesh_start_idx = submesh_count;
-    mesh->submesh_end_idx = submesh_count + gltf->meshes[i].primitives_count;
+  if (entity_count >= ENTITY_BVH_MIN_COUNT && update_entity_bvh()) {
+    drawn_entity_count = bvh_cull(&entity_bvh, entity_transforms.visible_next, frustum, entity_transforms.world_center, entity_transforms.world_extent);
+  } else {
+    drawn_entity_count = frustum_cull_soa(entity_transforms.visible_next, frustum, entity_transforms.world_center, entity_transforms.world_extent, entity_count);
+  }
+  culled_entity_count = entity_count - drawn_entity_count;
 
-    printf("-- meshes[%d] <= gltf mesh %d (submeshes %d - %d (#%d))\n", mesh_count - 1, i, mesh->submesh_start_idx, mesh->submesh_end_idx, (int32_t)gltf->meshes[i].primitives_count);
+  if (memcmp(entity_transforms.visible, entity_transforms.visible_next, (size_t)entity_count) != 0) {
+    uint8_t *visible = entity_transforms.visible;
+    entity_transforms.visible = entity_transforms.visible_next;
+    entity_transforms.visible_next = visible;
+    instance_layout_dirty = 1;
+  }
+}
 
-    for (int32_t j = 0, jlen = gltf->meshes[i].primitives_count; j < jlen; ++j) {
-      cgltf_primitive *prim = &gltf->meshes[i].primitives[j];
+/*
+ * groups model matrices of visible entities by mesh so every submesh is
+ * drawn once with all its instances. entities whose asset is not ready
+ * get no instance.
+ */
+static void update_instances(void)
+{
+  struct entity *entities = entity_pool.items;
+  int32_t entity_count = (int32_t)entity_pool.count;
 
-      struct submesh *submesh = &submeshes[submesh_count++];
-      assert(submesh_count < MAX_SUBMESH_COUNT);
+  if (instance_layout_dirty) {
+    reserve_instances(drawn_entity_count);
 
-      cgltf_attribute *attrs = prim->attributes;
-      for (int32_t k = 0, klen = prim->attributes_count; k < klen; ++k) {
-        cgltf_accessor *acc = prim->attributes[k].data;
-        int32_t acc_offset = (int32_t)acc->offset;
-        int32_t buffer_view_idx = (int32_t)((cgltf_buffer_view *)acc->buffer_view - (cgltf_buffer_view *)gltf->buffer_views);
-        submesh->buffer_indices[k] = buffer_base_idx + buffer_view_idx;
-        submesh->buffer_offsets[k] = acc_offset;
+    for (int32_t i = 0, ilen = mesh_count; i < ilen; ++i) {
+      meshes[i].instance_count = 0;
+    }
+    instanced_entity_count = 0;
+    for (int32_t i = 0, ilen = entity_count; i < ilen; ++i) {
+      struct mesh *mesh = entity_mesh(&entities[i]);
+      if (mesh && entity_transforms.visible[i]) {
+        ++mesh->instance_count;
+        ++instanced_entity_count;
       }
-      cgltf_accessor *indices = prim->indices;
-      int32_t ibuffer_view_idx = (int32_t)((cgltf_buffer_view *)indices->buffer_view - (cgltf_buffer_view *)gltf->buffer_views);
-      submesh->buffer_indices[3] = buffer_base_idx + ibuffer_view_idx;
-      submesh->buffer_offsets[3] = (int32_t)indices->offset;
-
-      submesh->element_count = prim->indices->count;
-
-      submesh->pipeline_idx = pipeline_count;
-      pipelines[pipeline_count++] = sg_make_pipeline(&(sg_pipeline_desc){
-        .layout = {
-          .buffers = {
-            [0].stride = 12,
-            [1].stride = 12,
-            [2].stride = 8},
-          .attrs = {
-            [ATTR_vs_position] = {
-              .format = SG_VERTEXFORMAT_FLOAT3,
-              .offset = 0,
-              .buffer_index = 0,
-            },
-            [ATTR_vs_normal] = {
-              .format = SG_VERTEXFORMAT_FLOAT3,
-              .offset = 0,
-              .buffer_index = 1,
-            },
-            [ATTR_vs_texcoord] = {
-              .format = SG_VERTEXFORMAT_FLOAT2,
-              .offset = 0,
-              .buffer_index = 2,
-            },
-          },
-        },
-        .shader = shader,
-        .index_type = SG_INDEXTYPE_UINT16,
-        .depth_stencil = {
-          .depth_compare_func = SG_COMPAREFUNC_LESS_EQUAL,
-          .depth_write_enabled = true,
-        },
-        .rasterizer.sample_count = SAMPLE_COUNT,
-      });
-      assert(pipeline_count < MAX_SUBMESH_COUNT);
-      printf("-- -- submesh[%d] <= gltf primitive %d (pipeline_idx = %d)\n", submesh_count - 1, j, pipeline_count - 1);
     }
+    for (int32_t i = 0, instance_start = 0, ilen = mesh_count; i < ilen; ++i) {
+      meshes[i].instance_start = instance_start;
+      instance_start += meshes[i].instance_count;
+      meshes[i].instance_count = 0;
+    }
+    for (int32_t i = 0, ilen = entity_count; i < ilen; ++i) {
+      struct mesh *mesh = entity_mesh(&entities[i]);
+      if (!mesh || !entity_transforms.visible[i]) {
+        entity_transforms.instance_index[i] = -1;
+        continue;
+      }
+      int32_t instance_index = mesh->instance_start + mesh->instance_count++;
+      entity_transforms.instance_index[i] = instance_index;
+      instances[instance_index] = mesh_instance(mesh, entity_transforms.model[i]);
+    }
+    instance_layout_dirty = 0;
+    instance_data_dirty = 1;
+  }
+
+  if (instance_data_dirty && instanced_entity_count > 0) {
+    sg_update_buffer(instance_buffer, instances, instanced_entity_count * (int32_t)sizeof(struct instance));
   }
+  instance_data_dirty = 0;
 }
 
-static void load_gltf_buffers(cgltf_data *gltf)
+/*
+ * queues a draw per submesh of every mesh with visible instances and sorts
+ * them so draws sharing a pipeline and buffers end up next to each other
+ */
+static void build_render_queue(struct mat4 view_proj)
 {
-  assert(gltf->buffers && gltf->buffer_views && gltf->accessors);
-  printf("load_gltf_buffers\n");
+  draws = buffer_arena_push(&frame_arena, (uint64_t)submesh_count * sizeof(struct draw), 0);
+  draw_keys = buffer_arena_push(&frame_arena, (uint64_t)submesh_count * sizeof(uint64_t), 0);
+  draw_keys_scratch = buffer_arena_push(&frame_arena, (uint64_t)submesh_count * sizeof(uint64_t), 0);
+  assert(draws && draw_keys && draw_keys_scratch);
+  draw_count = 0;
 
-  for (int32_t i = 0, len = gltf->buffer_views_count; i < len; ++i) {
-    cgltf_buffer_view *buf_view = &gltf->buffer_views[i];
+  for (int32_t i = 0, ilen = mesh_count; i < ilen; ++i) {
+    struct mesh mesh = meshes[i];
+    if (mesh.instance_count == 0) {
+      continue;
+    }
+
+    /* instances aren't depth sorted, the first one's mesh center stands in for the mesh. clip w is the view depth */
+    struct affine3x4 model = instances[mesh.instance_start].model;
+    struct vec3 origin = v3(model.x.w, model.y.w, model.z.w);
+    float depth = view_proj.x.w * origin.x + view_proj.y.w * origin.y + view_proj.z.w * origin.z + view_proj.w.w;
+    float depth_unit = fminf(fmaxf(depth / CAMERA_Z_FAR, 0.0f), 1.0f);
+    uint64_t depth_key = (uint64_t)(depth_unit * (float)DRAW_KEY_DEPTH_MAX);
+
+    /* draws past the index field are dropped, their keys would alias the first ones */
+    for (int32_t j = mesh.submesh_start_idx, jlen = mesh.submesh_end_idx; j < jlen && draw_count <= DRAW_KEY_INDEX_MASK; ++j) {
+      draws[draw_count] = (struct draw){
+        .submesh_idx = j,
+        .instance_start = mesh.instance_start,
+        .instance_count = mesh.instance_count,
+      };
+      draw_keys[draw_count] = ((uint64_t)submeshes[j].pipeline_idx << DRAW_KEY_PIPELINE_SHIFT) |
+                              ((uint64_t)submeshes[j].vertex_buffer_idx << DRAW_KEY_BUFFER_SHIFT) |
+                              (depth_key << DRAW_KEY_DEPTH_SHIFT) |
+                              (uint64_t)draw_count;
+      ++draw_count;
+    }
+  }
+
+  radix_sort_u64(draw_keys, draw_keys_scratch, draw_count);
+}
+
+static double time_now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static uint64_t hash_bytes(const void *data, size_t size)
+{
+  /* FNV-1a */
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/*
+ * returns the index of a pipeline created from a byte-identical desc, or
+ * makes a new one. descs are hashed and compared as raw bytes, padding
+ * included, so callers must memset the desc to zero and then set its fields;
+ * a compound literal or struct copy leaves the padding unspecified.
+ */
+static int32_t pipeline_cache_get(const sg_pipeline_desc *desc)
+{
+  uint64_t hash = hash_bytes(desc, sizeof(*desc));
+  uint32_t slot = (uint32_t)hash & (pipeline_cache_size - 1);
+
+  while (pipeline_cache[slot] != 0) {
+    int32_t pipeline_idx = pipeline_cache[slot] - 1;
+    if (pipeline_hashes[pipeline_idx] == hash && memcmp(&pipeline_descs[pipeline_idx], desc, sizeof(*desc)) == 0) {
+      return pipeline_idx;
+    }
+    slot = (slot + 1) & (pipeline_cache_size - 1);
+  }
 
-    int32_t buffer_idx = (int32_t)((cgltf_buffer *)buf_view->buffer - (cgltf_buffer *)gltf->buffers);
+  assert(pipeline_count < pipeline_capacity);
+  int32_t pipeline_idx = pipeline_count++;
+  pipelines[pipeline_idx] = sg_make_pipeline(desc);
+  memcpy(&pipeline_descs[pipeline_idx], desc, sizeof(*desc));
+  pipeline_hashes[pipeline_idx] = hash;
+  pipeline_cache[slot] = pipeline_idx + 1;
+  return pipeline_idx;
+}
+
+/* initializes the allocated vertex and index buffer of one file and appends its meshes and submeshes */
+static void upload_mesh_data(const struct mesh_data *data, int32_t vertex_buffer_idx, int32_t index_buffer_idx)
+{
+  printf("upload_mesh_data\n");
+
+  meshes = reserve_items(meshes, &mesh_capacity, mesh_count + data->mesh_count, sizeof(struct mesh));
+  submeshes = reserve_items(submeshes, &submesh_capacity, submesh_count + data->submesh_count, sizeof(struct submesh));
+
+  sg_index_type index_type = (data->index_size == sizeof(uint16_t)) ? SG_INDEXTYPE_UINT16 : SG_INDEXTYPE_UINT32;
+  /* set field by field on zeroed memory, a compound literal leaves padding unspecified for the cache */
+  sg_pipeline_desc pipeline_desc;
+  memset(&pipeline_desc, 0, sizeof(pipeline_desc));
+  pipeline_desc.layout.buffers[0].stride = sizeof(struct packed_vertex);
+  pipeline_desc.layout.buffers[1].stride = sizeof(struct instance);
+  pipeline_desc.layout.buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE;
+  pipeline_desc.layout.attrs[ATTR_vs_position].format = SG_VERTEXFORMAT_SHORT4N;
+  pipeline_desc.layout.attrs[ATTR_vs_position].offset = offsetof(struct packed_vertex, position);
+  pipeline_desc.layout.attrs[ATTR_vs_normal].format = SG_VERTEXFORMAT_BYTE4N;
+  pipeline_desc.layout.attrs[ATTR_vs_normal].offset = offsetof(struct packed_vertex, normal);
+  pipeline_desc.layout.attrs[ATTR_vs_texcoord].format = SG_VERTEXFORMAT_SHORT2N;
+  pipeline_desc.layout.attrs[ATTR_vs_texcoord].offset = offsetof(struct packed_vertex, texcoord);
+  pipeline_desc.layout.attrs[ATTR_vs_model0].format = SG_VERTEXFORMAT_FLOAT4;
+  pipeline_desc.layout.attrs[ATTR_vs_model0].offset = offsetof(struct instance, model.x);
+  pipeline_desc.layout.attrs[ATTR_vs_model0].buffer_index = 1;
+  pipeline_desc.layout.attrs[ATTR_vs_model1].format = SG_VERTEXFORMAT_FLOAT4;
+  pipeline_desc.layout.attrs[ATTR_vs_model1].offset = offsetof(struct instance, model.y);
+  pipeline_desc.layout.attrs[ATTR_vs_model1].buffer_index = 1;
+  pipeline_desc.layout.attrs[ATTR_vs_model2].format = SG_VERTEXFORMAT_FLOAT4;
+  pipeline_desc.layout.attrs[ATTR_vs_model2].offset = offsetof(struct instance, model.z);
+  pipeline_desc.layout.attrs[ATTR_vs_model2].buffer_index = 1;
+  pipeline_desc.layout.attrs[ATTR_vs_texcoord_transform].format = SG_VERTEXFORMAT_FLOAT4;
+  pipeline_desc.layout.attrs[ATTR_vs_texcoord_transform].offset = offsetof(struct instance, texcoord_transform);
+  pipeline_desc.layout.attrs[ATTR_vs_texcoord_transform].buffer_index = 1;
+  pipeline_desc.shader = shader;
+  pipeline_desc.index_type = index_type;
+  pipeline_desc.depth_stencil.depth_compare_func = SG_COMPAREFUNC_LESS_EQUAL;
+  pipeline_desc.depth_stencil.depth_write_enabled = true;
+  pipeline_desc.rasterizer.sample_count = SAMPLE_COUNT;
+  int32_t pipeline_idx = pipeline_cache_get(&pipeline_desc);
 
-    printf("-- buffers[%d] <= gltf buffer_view %d (buffer %d)\n", buffer_count, i, buffer_idx);
-    buffers[buffer_count++] = sg_make_buffer(&(sg_buffer_desc){
-      .type = (buf_view->type == cgltf_buffer_view_type_indices) ? SG_BUFFERTYPE_INDEXBUFFER : SG_BUFFERTYPE_VERTEXBUFFER,
-      .size = buf_view->size,
-      .content = (uint8_t *)(gltf->buffers[buffer_idx].data) + buf_view->offset});
-    assert(buffer_count < MAX_BUFFER_COUNT);
+  printf("-- buffers[%d] <= %d packed vertices, buffers[%d] <= %d indices\n", vertex_buffer_idx, data->vertex_count, index_buffer_idx, data->index_count);
+  sg_init_buffer(buffers[vertex_buffer_idx], &(sg_buffer_desc){
+    .type = SG_BUFFERTYPE_VERTEXBUFFER,
+    .size = data->vertex_count * (int32_t)sizeof(struct packed_vertex),
+    .content = data->vertices,
+  });
+  sg_init_buffer(buffers[index_buffer_idx], &(sg_buffer_desc){
+    .type = SG_BUFFERTYPE_INDEXBUFFER,
+    .size = data->index_count * data->index_size,
+    .content = data->indices,
+  });
+
+  for (int32_t i = 0, ilen = data->mesh_count; i < ilen; ++i) {
+    const struct mesh_data_mesh *mesh_data = &data->meshes[i];
+    struct mesh *mesh = &meshes[mesh_count++];
+    mesh->submesh_start_idx = submesh_count + mesh_data->submesh_start;
+    mesh->submesh_end_idx = mesh->submesh_start_idx + mesh_data->submesh_count;
+    mesh->instance_start = 0;
+    mesh->instance_count = 0;
+    mesh->bounds = mesh_data->bounds;
+    mesh->position_scale = mesh_data->position_scale;
+    mesh->position_offset = mesh_data->position_offset;
+    mesh->texcoord_transform = mesh_data->texcoord_transform;
+    printf("-- meshes[%d] (submeshes %d - %d (#%d))\n", mesh_count - 1, mesh->submesh_start_idx, mesh->submesh_end_idx, mesh_data->submesh_count);
+  }
+  for (int32_t i = 0, ilen = data->submesh_count; i < ilen; ++i) {
+    const struct mesh_data_submesh *submesh_data = &data->submeshes[i];
+    struct submesh *submesh = &submeshes[submesh_count++];
+    submesh->vertex_buffer_idx = vertex_buffer_idx;
+    submesh->index_buffer_idx = index_buffer_idx;
+    submesh->base_element = submesh_data->base_element;
+    submesh->element_count = submesh_data->element_count;
+    submesh->pipeline_idx = pipeline_idx;
+    submesh->bounds = submesh_data->bounds;
+    printf("-- -- submesh[%d] (pipeline_idx = %d, base_element = %d)\n", submesh_count - 1, submesh->pipeline_idx, submesh->base_element);
   }
-  return;
 }
 
-static void load_gltf(const char *filename)
+/* live ready asset holding the same contents under any path, or -1 */
+static int32_t asset_find_content(uint64_t content_hash)
 {
-  struct buffer gltf_buffer = buffer_create_from_file(filename);
-  printf("load gltf file %s %d\n", filename, gltf_buffer.size);
+  for (int32_t i = 0; i < asset_count; ++i) {
+    if (assets[i].ref_count > 0 && assets[i].state == ASSET_READY && assets[i].content_hash == content_hash) {
+      return i;
+    }
+  }
+  return -1;
+}
 
-  cgltf_options options = {0};
-  cgltf_data *gltf = NULL;
-  const cgltf_result parse_result = cgltf_parse(&options, gltf_buffer.data, gltf_buffer.size, &gltf);
-  assert(parse_result == cgltf_result_success);
+/* live asset streaming in or ready from the same path, or -1 */
+static int32_t asset_find_path(uint64_t path_hash)
+{
+  for (int32_t i = 0; i < asset_count; ++i) {
+    if (assets[i].ref_count > 0 && assets[i].state != ASSET_FAILED && assets[i].path_hash == path_hash) {
+      return i;
+    }
+  }
+  return -1;
+}
 
-  const cgltf_result load_buf_result = cgltf_load_buffers(&options, gltf, NULL);
-  assert(load_buf_result == cgltf_result_success);
+/*
+ * new loading asset with allocated but uninitialized buffers and no
+ * references. when buffers has no two free slots it is created failed.
+ */
+static int32_t asset_create(uint64_t path_hash)
+{
+  assets = reserve_items(assets, &asset_capacity, asset_count + 1, sizeof(struct asset));
+  int32_t asset_idx = asset_count++;
+  struct asset *asset = &assets[asset_idx];
+  memset(asset, 0, sizeof(*asset));
+  asset->path_hash = path_hash;
+  asset->state = ASSET_LOADING;
+  asset->mesh_start = -1;
+  asset->source_idx = -1;
+  asset->vertex_buffer_idx = buffer_slot_alloc();
+  asset->index_buffer_idx = buffer_slot_alloc();
+  if (asset->vertex_buffer_idx < 0 || asset->index_buffer_idx < 0) {
+    printf("-- asset[%d] has no free buffer slots\n", asset_idx);
+    buffer_slot_free(asset->vertex_buffer_idx);
+    buffer_slot_free(asset->index_buffer_idx);
+    asset->vertex_buffer_idx = -1;
+    asset->index_buffer_idx = -1;
+    asset->state = ASSET_FAILED;
+  }
+  return asset_idx;
+}
 
-  int32_t buffer_base_idx = buffer_count;
-  load_gltf_buffers(gltf);
-  load_gltf_meshes(gltf, buffer_base_idx);
+static void asset_init(int32_t asset_idx, const struct mesh_data *data, uint64_t content_hash)
+{
+  struct asset *asset = &assets[asset_idx];
+  assert(asset->state == ASSET_LOADING);
+  asset->content_hash = content_hash;
+  asset->mesh_start = mesh_count;
+  asset->mesh_count = data->mesh_count;
+  upload_mesh_data(data, asset->vertex_buffer_idx, asset->index_buffer_idx);
+  asset->state = ASSET_READY;
+}
 
-  cgltf_free(gltf);
+/* points a loading asset at the meshes and buffers of a ready one holding the same file */
+static void asset_share(int32_t asset_idx, int32_t source_idx)
+{
+  struct asset *asset = &assets[asset_idx];
+  struct asset *source = &assets[source_idx];
+  assert(asset->state == ASSET_LOADING && source->state == ASSET_READY);
+  buffer_slot_free(asset->vertex_buffer_idx);
+  buffer_slot_free(asset->index_buffer_idx);
+  asset->content_hash = source->content_hash;
+  asset->mesh_start = source->mesh_start;
+  asset->mesh_count = source->mesh_count;
+  asset->vertex_buffer_idx = source->vertex_buffer_idx;
+  asset->index_buffer_idx = source->index_buffer_idx;
+  asset->source_idx = source_idx;
+  ++source->ref_count;
+  asset->state = ASSET_READY;
+}
+
+static void asset_fail(int32_t asset_idx)
+{
+  struct asset *asset = &assets[asset_idx];
+  assert(asset->state == ASSET_LOADING);
+  sg_fail_buffer(buffers[asset->vertex_buffer_idx]);
+  sg_fail_buffer(buffers[asset->index_buffer_idx]);
+  asset->state = ASSET_FAILED;
+}
+
+/*
+ * one file being streamed in. mesh_file_load_prepare reads, hashes and
+ * decodes it on any thread: it doesn't touch the asset table and makes no
+ * sokol_gfx calls. the arena must not be used by another thread meanwhile.
+ */
+struct mesh_file_load {
+  const char *filename; // gltf path, the pack is looked up next to it
+  uint64_t content_hash;
+  int32_t failed;
+  struct mesh_data data;  // valid when mapped or decoded
+  int32_t data_decoded;   // data was decoded from gltf and is owned by the load
+  struct buffer pack;     // file data points into when the pack was used
+};
+
+static void mesh_file_load_prepare(struct mesh_file_load *load, struct buffer_arena *arena)
+{
+  char pack_filename[256];
+  load->pack = (struct buffer){0};
+  if (mesh_pack_filename(pack_filename, sizeof(pack_filename), load->filename)) {
+    load->pack = buffer_map_file(pack_filename);
+  }
+  if (load->pack.data) {
+    if (mesh_data_from_pack(load->pack.data, (size_t)load->pack.size, &load->data)) {
+      printf("load mesh pack %s %llu\n", pack_filename, (unsigned long long)load->pack.size);
+      load->content_hash = hash_bytes(load->pack.data, (size_t)load->pack.size);
+      return;
+    }
+    printf("mesh pack %s is stale, falling back to gltf\n", pack_filename);
+    buffer_destroy(&load->pack);
+  }
+
+  struct buffer gltf_buffer = buffer_map_file(load->filename);
+  printf("load gltf file %s %llu\n", load->filename, (unsigned long long)gltf_buffer.size);
+  if (gltf_buffer.size == 0) {
+    load->failed = 1;
+    return;
+  }
+  load->content_hash = hash_bytes(gltf_buffer.data, (size_t)gltf_buffer.size);
+  load->data_decoded = mesh_data_from_gltf(load->filename, gltf_buffer.data, (size_t)gltf_buffer.size, &load->data, arena);
+  load->failed = !load->data_decoded;
   buffer_destroy(&gltf_buffer);
+}
 
-  return;
+/* frees what prepare left behind */
+static void mesh_file_load_discard(struct mesh_file_load *load)
+{
+  if (load->data_decoded) {
+    mesh_data_free(&load->data);
+    load->data_decoded = 0;
+  }
+  if (load->pack.data) {
+    buffer_destroy(&load->pack);
+  }
 }
 
-static void init(void)
+/*
+ * asset streaming. load_mesh_file_async hands out a loading asset right
+ * away, entities can use it at once and are skipped by update_instances
+ * until it is ready. a worker of job_system prepares the file, then
+ * update_streaming initializes the allocated buffers from the main thread,
+ * a few assets per frame so a large town streams in without hitches.
+ */
+#define STREAM_FRAME_BUDGET_MS 2.0
+#define STREAM_FRAME_MAX_UPLOADS 8
+
+struct stream_request {
+  struct mesh_file_load load;
+  char filename[256];
+  int32_t asset_idx;
+  int32_t prepared; // set by the worker once load is complete
+};
+
+static int32_t stream_request_count = 0;
+static int32_t stream_request_capacity = 0;
+static struct stream_request **stream_requests = 0;
+
+static void stream_request_prepare(void *data, int32_t worker)
+{
+  struct stream_request *request = data;
+  mesh_file_load_prepare(&request->load, &load_arenas[worker]);
+  __atomic_store_n(&request->prepared, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * returns the asset of a gltf file, or of the cooked pack next to it (same
+ * name, MESH_PACK_EXTENSION) where there is a valid one, with one more
+ * reference. a path already streaming in or ready is returned as is, without
+ * reading the file again. once prepared, a file whose content hash matches
+ * a ready asset, under any path, shares that asset's meshes and buffers
+ * instead of being uploaded again.
+ */
+static int32_t load_mesh_file_async(const char *gltf_filename)
 {
+  uint64_t path_hash = hash_bytes(gltf_filename, strlen(gltf_filename));
+  int32_t asset_idx = asset_find_path(path_hash);
+  if (asset_idx >= 0) {
+    ++assets[asset_idx].ref_count;
+    return asset_idx;
+  }
+
+  asset_idx = asset_create(path_hash);
+  ++assets[asset_idx].ref_count;
+  if (assets[asset_idx].state == ASSET_FAILED) {
+    return asset_idx;
+  }
+
+  struct stream_request *request = calloc(1, sizeof(struct stream_request));
+  assert(request && strlen(gltf_filename) < sizeof(request->filename));
+  strcpy(request->filename, gltf_filename);
+  request->load.filename = request->filename;
+  request->asset_idx = asset_idx;
+  stream_requests = reserve_items(stream_requests, &stream_request_capacity, stream_request_count + 1, sizeof(struct stream_request *));
+  stream_requests[stream_request_count++] = request;
+  jobs_push(&job_system, stream_request_prepare, request);
+  return asset_idx;
+}
+
+/*
+ * finishes prepared requests in request order until budget_ms or
+ * max_uploads is used up. entities of assets that became ready get their
+ * bounds from the real mesh and their instances on the next layout.
+ */
+static void update_streaming(double budget_ms, int32_t max_uploads)
+{
+  if (stream_request_count == 0) {
+    return;
+  }
+
+  double start_ms = time_now_ms();
+  int32_t finished_count = 0;
+  int32_t ready_count = 0;
+  while (finished_count < stream_request_count && finished_count < max_uploads && time_now_ms() - start_ms < budget_ms) {
+    struct stream_request *request = stream_requests[finished_count];
+    if (!__atomic_load_n(&request->prepared, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    struct asset *asset = &assets[request->asset_idx];
+    int32_t source_idx = request->load.failed ? -1 : asset_find_content(request->load.content_hash);
+    if (asset->ref_count == 0) {
+      /* released while streaming in */
+      buffer_slot_free(asset->vertex_buffer_idx);
+      buffer_slot_free(asset->index_buffer_idx);
+      asset->vertex_buffer_idx = -1;
+      asset->index_buffer_idx = -1;
+      asset->state = ASSET_FAILED;
+    } else if (request->load.failed) {
+      asset_fail(request->asset_idx);
+    } else if (source_idx >= 0) {
+      asset_share(request->asset_idx, source_idx);
+      ++ready_count;
+    } else {
+      asset_init(request->asset_idx, &request->load.data, request->load.content_hash);
+      ++ready_count;
+    }
+    asset = &assets[request->asset_idx];
+    asset->ready_pending = (asset->state == ASSET_READY);
+    printf("-- asset[%d] (meshes %d - %d, %d references, state %d)\n", request->asset_idx, asset->mesh_start, asset->mesh_start + asset->mesh_count, asset->ref_count, asset->state);
+
+    mesh_file_load_discard(&request->load);
+    free(request);
+    ++finished_count;
+  }
+
+  stream_request_count -= finished_count;
+  memmove(stream_requests, stream_requests + finished_count, (size_t)stream_request_count * sizeof(struct stream_request *));
+
+  if (ready_count > 0) {
+    struct entity *entities = entity_pool.items;
+    for (uint32_t i = 0; i < entity_pool.count; ++i) {
+      if (assets[entities[i].asset_idx].ready_pending) {
+        entity_mark_dirty(i);
+      }
+    }
+    for (int32_t i = 0; i < asset_count; ++i) {
+      assets[i].ready_pending = 0;
+    }
+    instance_layout_dirty = 1;
+  }
+}
+
+/* waits for every request and finishes them all, e.g. before a benchmark */
+static void finish_streaming(void)
+{
+  jobs_wait(&job_system);
+  update_streaming(INFINITY, INT32_MAX);
+}
+
+static void setup_gfx(void)
+{
+#if defined(DEMO_HEADLESS)
+  sg_setup(&(sg_desc){0});
+#else
   sg_setup(&(sg_desc){
     .gl_force_gles2 = sapp_gles2(), .mtl_device = sapp_metal_get_device(), .mtl_renderpass_descriptor_cb = sapp_metal_get_renderpass_descriptor, .mtl_drawable_cb = sapp_metal_get_drawable});
+#endif
 
-  shader = sg_make_shader(demo_shader_desc());
+  shader = sg_make_shader(shader_desc());
 
-  /* load gltf files */
-  load_gltf("assets/toob.gltf");
-  load_gltf("assets/plus.gltf");
-  load_gltf("assets/toob.gltf");
-  load_gltf("assets/reggie.gltf");
+  /* sokol_gfx can't hold more buffers or pipelines than its pools, nor the draw keys more than their fields */
+  sg_desc gfx_desc = sg_query_desc();
+  buffer_capacity = (gfx_desc.buffer_pool_size < DRAW_KEY_MAX_BUFFERS) ? gfx_desc.buffer_pool_size : DRAW_KEY_MAX_BUFFERS;
+  buffers = calloc((size_t)buffer_capacity, sizeof(sg_buffer));
 
-  for (int32_t i = 0, ilen = mesh_count; i < ilen; ++i) {
+  pipeline_capacity = (gfx_desc.pipeline_pool_size < DRAW_KEY_MAX_PIPELINES) ? gfx_desc.pipeline_pool_size : DRAW_KEY_MAX_PIPELINES;
+  pipelines = calloc((size_t)pipeline_capacity, sizeof(sg_pipeline));
+  pipeline_descs = calloc((size_t)pipeline_capacity, sizeof(sg_pipeline_desc));
+  pipeline_hashes = calloc((size_t)pipeline_capacity, sizeof(uint64_t));
+  pipeline_cache_size = 1;
+  while (pipeline_cache_size <= (uint32_t)pipeline_capacity) {
+    pipeline_cache_size *= 2;
+  }
+  pipeline_cache = calloc(pipeline_cache_size, sizeof(int32_t));
+  assert(buffers && pipelines && pipeline_descs && pipeline_hashes && pipeline_cache);
+
+  meshes = reserve_items(meshes, &mesh_capacity, INITIAL_MESH_CAPACITY, sizeof(struct mesh));
+  submeshes = reserve_items(submeshes, &submesh_capacity, INITIAL_SUBMESH_CAPACITY, sizeof(struct submesh));
+  pool_init(&entity_pool, sizeof(struct entity), INITIAL_ENTITY_CAPACITY);
+
+  reserve_instances(INITIAL_ENTITY_CAPACITY);
+
+  buffer_arena_create(&frame_arena, FRAME_ARENA_CAPACITY);
+  for (int32_t i = 0; i < JOBS_MAX_THREADS + 1; ++i) {
+    /* unused workers' arenas stay empty, the first file a worker decodes sizes its buffer */
+    buffer_arena_create(&load_arenas[i], 0);
+  }
+}
+
+static void load_scene(void)
+{
+  /* stream in gltf files, or their cooked packs. the scene keeps its references for its lifetime */
+  static const char *const scene_files[] = {
+    "assets/toob.gltf",
+    "assets/plus.gltf",
+    "assets/toob.gltf",
+    "assets/reggie.gltf",
+  };
+  int32_t scene_asset_count = (int32_t)(sizeof(scene_files) / sizeof(scene_files[0]));
+
+  for (int32_t i = 0, ilen = scene_asset_count; i < ilen; ++i) {
     float scale_factor = (float)(i + 1.0f) * 0.5f;
-    entities[entity_count++] = (struct entity){
-      .mesh_idx = i,
-      .position = {
-        .x = -((float)mesh_count * 10.0f / 2.0f) + ((float)i * 10.f) + 5.0f,
-        .y = 0.0f,
-        .z = 0.0f,
-      },
-      .rotation = {
-        .x = -90.0f,
-        .y = 0.0f,
-        .z = 0.0f,
-      },
-      .scale = {
-        .x = scale_factor,
-        .y = scale_factor,
-        .z = scale_factor,
-      },
-    };
-    assert(entity_count < MAX_ENTITY_COUNT);
+    uint32_t entity_id = entity_add(
+      load_mesh_file_async(scene_files[i]),
+      0,
+      v3(-((float)scene_asset_count * 10.0f / 2.0f) + ((float)i * 10.f) + 5.0f, 0.0f, 0.0f),
+      quat_axis_angle(v3(1.0f, 0.0f, 0.0f), WATT_RAD_FROM_DEG(-90.0f)),
+      v3(scale_factor, scale_factor, scale_factor));
+    if (i == 1) player_entity_id = entity_id;
   }
 }
 
+static void init(void)
+{
+  setup_gfx();
+  /* files stream in beside the frame loop */
+  jobs_create(&job_system, jobs_cpu_count());
+  load_scene();
+}
+
 void cleanup(void)
 {
+  /* drops the entities' asset references while their buffers can still be destroyed */
+  entity_clear();
   sg_shutdown();
+
+  jobs_destroy(&job_system);
+  for (int32_t i = 0; i < stream_request_count; ++i) {
+    mesh_file_load_discard(&stream_requests[i]->load);
+    free(stream_requests[i]);
+  }
+  free(stream_requests);
+  pool_destroy(&entity_pool);
+  free_entity_transforms();
+  bvh_destroy(&entity_bvh);
+  free(instances);
+  buffer_arena_destroy(&frame_arena);
+  for (int32_t i = 0; i < JOBS_MAX_THREADS + 1; ++i) {
+    buffer_arena_destroy(&load_arenas[i]);
+  }
+  free(meshes);
+  free(submeshes);
+  free(assets);
+  free(pipeline_cache);
+  free(pipeline_hashes);
+  free(pipeline_descs);
+  free(pipelines);
+  free(buffers);
 }
 
+#if !defined(DEMO_HEADLESS)
 static void event(const sapp_event *e)
 {
   int32_t event_type = e->type;
@@ -310,32 +1328,120 @@ static void event(const sapp_event *e)
     case SAPP_KEYCODE_Q:
       input_button_process(&input_state.quit, is_down);
       break;
+    case SAPP_KEYCODE_DELETE:
+    case SAPP_KEYCODE_BACKSPACE:
+      input_button_process(&input_state.action, is_down);
+      break;
     default:
       break;
     }
+  } else if (event_type == SAPP_EVENTTYPE_MOUSE_DOWN || event_type == SAPP_EVENTTYPE_MOUSE_UP) {
+    if (e->mouse_button == SAPP_MOUSEBUTTON_LEFT) {
+      input_button_process(&input_state.lmb, event_type == SAPP_EVENTTYPE_MOUSE_DOWN);
+    }
+    input_state.mouse_x = e->mouse_x;
+    input_state.mouse_y = e->mouse_y;
+  } else if (event_type == SAPP_EVENTTYPE_MOUSE_MOVE) {
+    input_state.mouse_x = e->mouse_x;
+    input_state.mouse_y = e->mouse_y;
   }
 }
+#endif
 
-static void process_input(struct input *input_state)
+static struct mat4 camera_view_proj(void)
 {
-  struct entity *entity = &entities[1];
+  float aspect = (float)display_width() / (float)display_height();
+  struct mat4 proj = mat4_perspective(CAMERA_FOV, aspect, CAMERA_Z_NEAR, CAMERA_Z_FAR);
+  struct mat4 view = mat4_look_at(camera_position, vec3_add(camera_target, vec3_scale(camera_position, -1.0f)), v3(0.0f, 1.0f, 0.0f));
+  return mat4_multiply(proj, view);
+}
 
+/* world space ray through a window pixel, window y grows downwards */
+static struct ray camera_ray(float x, float y)
+{
+  struct vec2 ndc = v2(2.0f * x / (float)display_width() - 1.0f, 1.0f - 2.0f * y / (float)display_height());
+  return unproject_ray(ndc, mat4_inverse(camera_view_proj()));
+}
+
+static void process_input(struct input *input_state)
+{
   if (input_state->quit.is_down) {
     cleanup();
     exit(0);
   }
 
+  uint32_t index = pool_index(&entity_pool, player_entity_id);
+  if (index == POOL_INVALID_INDEX) {
+    return;
+  }
+
+  /* delete removes the player entity, clicking another one makes it the player */
+  if (input_state->action.was_down) {
+    input_state->action.was_down = 0;
+    entity_remove(player_entity_id);
+    player_entity_id = POOL_INVALID_ID;
+    return;
+  }
+
   if (input_state->left.is_down || input_state->right.is_down) {
-    entity->rotation.z += 5.0f * (input_state->right.is_down ? -1.0f : 1.0f);
+    float angle = WATT_RAD_FROM_DEG(5.0f) * (input_state->right.is_down ? -1.0f : 1.0f);
+    entity_turn(index, quat_axis_angle(v3(0.0f, 0.0f, 1.0f), angle));
   }
 
   if (input_state->up.is_down || input_state->down.is_down) {
-    int32_t is_up = input_state->up.is_down;
-    float z_inc = cosf(WATT_RAD_FROM_DEG(entity->rotation.z));
-    float x_inc = sinf(WATT_RAD_FROM_DEG(entity->rotation.z));
+    /* the models face down their local -y, which the scene's x rotation turns into the ground plane */
+    struct vec3 forward = quat_rotate(v3(0.0f, -1.0f, 0.0f), entity_rotation(index));
     float direction = (input_state->up.is_down ? 1.0f : -1.0f) * 0.5f;
-    entity->position.x += x_inc * direction;
-    entity->position.z += z_inc * direction;
+    entity_transforms.position.x[index] += forward.x * direction;
+    entity_transforms.position.z[index] += forward.z * direction;
+    entity_mark_dirty(index);
+  }
+}
+
+/*
+ * nearest entity whose world bounds the ray hits, or BVH_INVALID_ITEM. walks
+ * the bvh when it is current, otherwise tests every entity like cull_entities.
+ */
+static int32_t raycast_entities(struct ray ray, float *distance)
+{
+  if (!entity_bvh_dirty) {
+    return bvh_raycast(&entity_bvh, ray.origin, ray.direction, entity_transforms.world_center, entity_transforms.world_extent, distance);
+  }
+
+  struct vec3_soa center = entity_transforms.world_center;
+  struct vec3_soa extent = entity_transforms.world_extent;
+  int32_t best_index = BVH_INVALID_ITEM;
+  float best_distance = INFINITY;
+  float hit_distance = 0.0f;
+  for (int32_t i = 0, ilen = (int32_t)entity_pool.count; i < ilen; ++i) {
+    struct aabb box = {
+      v3(center.x[i] - extent.x[i], center.y[i] - extent.y[i], center.z[i] - extent.z[i]),
+      v3(center.x[i] + extent.x[i], center.y[i] + extent.y[i], center.z[i] + extent.z[i]),
+    };
+    if (ray_intersect_aabb(ray.origin, ray.direction, box, best_distance, &hit_distance) && hit_distance < best_distance) {
+      best_index = i;
+      best_distance = hit_distance;
+    }
+  }
+  if (best_index != BVH_INVALID_ITEM && distance) {
+    *distance = best_distance;
+  }
+  return best_index;
+}
+
+/* left click selects the entity under the cursor as the player */
+static void pick_entity(struct input *input_state)
+{
+  if (!input_state->lmb.was_down) {
+    return;
+  }
+  input_state->lmb.was_down = 0;
+
+  float distance = 0.0f;
+  int32_t index = raycast_entities(camera_ray(input_state->mouse_x, input_state->mouse_y), &distance);
+  if (index != BVH_INVALID_ITEM) {
+    player_entity_id = pool_item_id(&entity_pool, (uint32_t)index);
+    printf("picked entity %u at distance %.2f\n", player_entity_id, distance);
   }
 }
 
@@ -344,24 +1450,16 @@ static void frame(void)
   static int32_t frame_count = 0;
   ++frame_count;
 
+  buffer_arena_reset(&frame_arena, (struct buffer_arena_mark){0});
   process_input(&input_state);
+  update_streaming(STREAM_FRAME_BUDGET_MS, STREAM_FRAME_MAX_UPLOADS);
 
   /* NOTE: the vs_params_t struct has been code-generated by the shader-code-gen */
   vs_params_t vs_params;
-  const float w = (float)sapp_width();
-  const float h = (float)sapp_height();
+  const float w = (float)display_width();
+  const float h = (float)display_height();
 
-  struct vec3 camera_position = {
-    .x = 0.0f,
-    .y = 50.0f,
-    .z = 50.0f,
-  };
-
-  struct vec3 camera_direction = vec3_add(v3(0.0f, 0.0f, 0.0f), vec3_scale(camera_position, -1.0f));
-
-  struct mat4 proj = mat4_perspective(60.0f / 180.0f * WATT_PI32, w / h, 0.01f, 1000.0f);
-  struct mat4 view = mat4_look_at(camera_position, camera_direction, v3(0.0f, 1.0f, 0.0f));
-  struct mat4 view_proj = mat4_multiply(proj, view);
+  struct mat4 view_proj = camera_view_proj();
 
   sg_pass_action pass_action = {
     .colors[0] = {
@@ -372,55 +1470,55 @@ static void frame(void)
 
   sg_begin_default_pass(&pass_action, (int32_t)w, (int32_t)h);
 
-  if (frame_count == 1) printf("render\n");
-  for (int32_t i = 0, ilen = entity_count; i < ilen; ++i) {
-    struct entity entity = entities[i];
-    struct mesh mesh = meshes[entity.mesh_idx];
-    if (frame_count == 1) printf("-- mesh %d\n", entity.mesh_idx);
-
-    // calc mvp
-    struct mat4 translated = mat4_translate(mat4_identity(), entity.position);
-    struct mat4 rotated_and_translated = mat4_rotate_z(
-      mat4_rotate_y(
-        mat4_rotate_x(
-          translated,
-          WATT_RAD_FROM_DEG(entity.rotation.x)),
-        WATT_RAD_FROM_DEG(entity.rotation.y)),
-      WATT_RAD_FROM_DEG(entity.rotation.z));
-    struct mat4 model = mat4_scale(rotated_and_translated, v3(entity.scale.x, entity.scale.y, entity.scale.z));
-
-    vs_params.mvp = mat4_multiply(view_proj, model);
-
-    for (int32_t j = mesh.submesh_start_idx, jlen = mesh.submesh_end_idx; j < jlen; ++j) {
-      struct submesh submesh = submeshes[j];
-      if (frame_count == 1) printf("-- -- render submesh %d (pipeline_idx = %d)\n", j, submesh.pipeline_idx);
-      if (frame_count == 1) printf("-- -- -- buffers %d %d %d %d\n", submesh.buffer_indices[0], submesh.buffer_indices[1], submesh.buffer_indices[2], submesh.buffer_indices[3]);
-
-      sg_apply_pipeline(pipelines[submesh.pipeline_idx]);
-      sg_bindings bindings = (sg_bindings){
-        .vertex_buffers = {
-          [0] = buffers[submesh.buffer_indices[0]],
-          [1] = buffers[submesh.buffer_indices[1]],
-          [2] = buffers[submesh.buffer_indices[2]],
-        },
-        .vertex_buffer_offsets = {
-          [0] = submesh.buffer_offsets[0],
-          [1] = submesh.buffer_offsets[1],
-          [2] = submesh.buffer_offsets[2],
-        },
-        .index_buffer = buffers[submesh.buffer_indices[3]],
-        .index_buffer_offset = submesh.buffer_offsets[3],
-      };
-      sg_apply_bindings(&bindings);
+  update_entity_transforms();
+  cull_entities(view_proj);
+  pick_entity(&input_state);
+  update_instances();
+  build_render_queue(view_proj);
 
+  vs_params.view_proj = view_proj;
+
+  /* sorted draws mostly share state with the previous one, only apply what changed */
+  sg_pipeline applied_pipeline = {SG_INVALID_ID};
+  sg_bindings applied_bindings = {0};
+
+  if (frame_count == 1) printf("render (entities drawn %d, culled %d, draws %d)\n", drawn_entity_count, culled_entity_count, draw_count);
+  for (int32_t i = 0, ilen = draw_count; i < ilen; ++i) {
+    struct draw draw = draws[draw_keys[i] & DRAW_KEY_INDEX_MASK];
+    struct submesh submesh = submeshes[draw.submesh_idx];
+    if (frame_count == 1) printf("-- render submesh %d (pipeline_idx = %d, instances %d)\n", draw.submesh_idx, submesh.pipeline_idx, draw.instance_count);
+    if (frame_count == 1) printf("-- -- buffers %d %d\n", submesh.vertex_buffer_idx, submesh.index_buffer_idx);
+
+    sg_pipeline pipeline = pipelines[submesh.pipeline_idx];
+    if (pipeline.id != applied_pipeline.id) {
+      sg_apply_pipeline(pipeline);
+      applied_pipeline = pipeline;
+      /* bindings and uniforms are resolved against the pipeline, apply them again. per-mesh data lives in the instances */
+      applied_bindings = (sg_bindings){0};
       sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_params, &vs_params, sizeof(vs_params));
-      sg_draw(0, submesh.element_count, 1);
     }
+    sg_bindings bindings = (sg_bindings){
+      .vertex_buffers = {
+        [0] = buffers[submesh.vertex_buffer_idx],
+        [1] = instance_buffer,
+      },
+      .vertex_buffer_offsets = {
+        [1] = draw.instance_start * (int32_t)sizeof(struct instance),
+      },
+      .index_buffer = buffers[submesh.index_buffer_idx],
+    };
+    if (memcmp(&bindings, &applied_bindings, sizeof(bindings)) != 0) {
+      sg_apply_bindings(&bindings);
+      applied_bindings = bindings;
+    }
+
+    sg_draw(submesh.base_element, submesh.element_count, draw.instance_count);
   }
   sg_end_pass();
   sg_commit();
 }
 
+#if !defined(DEMO_HEADLESS)
 sapp_desc sokol_main(int argc, char *argv[])
 {
   return (sapp_desc){
@@ -428,10 +1526,11 @@ sapp_desc sokol_main(int argc, char *argv[])
     .event_cb = event,
     .frame_cb = frame,
     .cleanup_cb = cleanup,
-    .width = 800,
-    .height = 600,
+    .width = DISPLAY_WIDTH,
+    .height = DISPLAY_HEIGHT,
     .sample_count = SAMPLE_COUNT,
     .gl_force_gles2 = true,
     .window_title = "builder.town",
   };
 }
+#endif
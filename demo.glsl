@@ -2,18 +2,28 @@
 
 @vs vs
 uniform vs_params {
-    mat4 mvp;
+    mat4 view_proj;
 };
 
-in vec3 position;
-in vec3 normal;
-in vec2 texcoord;
+in vec4 position; // snorm16 relative to the mesh bounds
+in vec4 normal;   // snorm8
+in vec2 texcoord; // snorm16 relative to the mesh texcoord bounds
+
+// per-instance struct instance, the rows of the affine model matrix with
+// the mesh's position dequantization folded in, see struct packed_vertex
+in vec4 model0;
+in vec4 model1;
+in vec4 model2;
+in vec4 texcoord_transform; // xy scale, zw offset
 
 out vec4 color;
 
 void main() {
-    gl_Position = mvp * vec4(position, 1.0);
-    color = vec4((normal + 1.0) * 0.5 + 0.000001 * texcoord.x, 1.0);
+    vec4 local = vec4(position.xyz, 1.0);
+    vec3 world = vec3(dot(model0, local), dot(model1, local), dot(model2, local));
+    vec2 uv = texcoord * texcoord_transform.xy + texcoord_transform.zw;
+    gl_Position = view_proj * vec4(world, 1.0);
+    color = vec4((normal.xyz + 1.0) * 0.5 + 0.000001 * uv.x, 1.0);
 }
 @end
 
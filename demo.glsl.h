@@ -13,6 +13,10 @@
                     ATTR_vs_position = 0
                     ATTR_vs_normal = 1
                     ATTR_vs_texcoord = 2
+                    ATTR_vs_model0 = 3
+                    ATTR_vs_model1 = 4
+                    ATTR_vs_model2 = 5
+                    ATTR_vs_texcoord_transform = 6
                 Uniform block 'vs_params':
                     C struct: vs_params_t
                     Bind slot: SLOT_vs_params = 0
@@ -31,6 +35,10 @@
                     [ATTR_vs_position] = { ... },
                     [ATTR_vs_normal] = { ... },
                     [ATTR_vs_texcoord] = { ... },
+                    [ATTR_vs_model0] = { ... },
+                    [ATTR_vs_model1] = { ... },
+                    [ATTR_vs_model2] = { ... },
+                    [ATTR_vs_texcoord_transform] = { ... },
                 },
             },
             ...});
@@ -41,7 +49,7 @@
     Bind slot and C-struct for uniform block 'vs_params':
 
         vs_params_t vs_params = {
-            .mvp = ...;
+            .view_proj = ...;
         };
         sg_apply_uniforms(SG_SHADERSTAGE_[VS|FS], SLOT_vs_params, &vs_params, sizeof(vs_params));
 
@@ -51,10 +59,14 @@
 #define ATTR_vs_position (0)
 #define ATTR_vs_normal (1)
 #define ATTR_vs_texcoord (2)
+#define ATTR_vs_model0 (3)
+#define ATTR_vs_model1 (4)
+#define ATTR_vs_model2 (5)
+#define ATTR_vs_texcoord_transform (6)
 #define SLOT_vs_params (0)
 #pragma pack(push,1)
 typedef struct vs_params_t {
-    mat4 mvp;
+    mat4 view_proj;
 } vs_params_t;
 #pragma pack(pop)
 #if !defined(SOKOL_SHDC_DECL)
@@ -66,42 +78,63 @@ typedef struct vs_params_t {
     #version 100
     
     uniform vec4 vs_params[4];
-    attribute vec3 position;
-    varying vec4 color;
-    attribute vec3 normal;
+    attribute vec4 position;
+    attribute vec4 model0;
+    attribute vec4 model1;
+    attribute vec4 model2;
     attribute vec2 texcoord;
+    attribute vec4 texcoord_transform;
+    varying vec4 color;
+    attribute vec4 normal;
     
     void main()
     {
-        gl_Position = mat4(vs_params[0], vs_params[1], vs_params[2], vs_params[3]) * vec4(position, 1.0);
-        color = vec4(((normal + vec3(1.0)) * 0.5) + vec3(9.9999999747524270787835121154785e-07 * texcoord.x), 1.0);
+        vec4 local = vec4(position.xyz, 1.0);
+        gl_Position = mat4(vs_params[0], vs_params[1], vs_params[2], vs_params[3]) * vec4(dot(model0, local), dot(model1, local), dot(model2, local), 1.0);
+        color = vec4(((normal.xyz + vec3(1.0)) * 0.5) + vec3(9.9999999747524270787835121154785e-07 * ((texcoord * texcoord_transform.xy) + texcoord_transform.zw).x), 1.0);
     }
     
 */
-static const char vs_source_glsl100[367] = {
+static const char vs_source_glsl100[619] = {
     0x23,0x76,0x65,0x72,0x73,0x69,0x6f,0x6e,0x20,0x31,0x30,0x30,0x0a,0x0a,0x75,0x6e,
     0x69,0x66,0x6f,0x72,0x6d,0x20,0x76,0x65,0x63,0x34,0x20,0x76,0x73,0x5f,0x70,0x61,
     0x72,0x61,0x6d,0x73,0x5b,0x34,0x5d,0x3b,0x0a,0x61,0x74,0x74,0x72,0x69,0x62,0x75,
-    0x74,0x65,0x20,0x76,0x65,0x63,0x33,0x20,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,
-    0x3b,0x0a,0x76,0x61,0x72,0x79,0x69,0x6e,0x67,0x20,0x76,0x65,0x63,0x34,0x20,0x63,
-    0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x20,
-    0x76,0x65,0x63,0x33,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x3b,0x0a,0x61,0x74,0x74,
-    0x72,0x69,0x62,0x75,0x74,0x65,0x20,0x76,0x65,0x63,0x32,0x20,0x74,0x65,0x78,0x63,
-    0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,0x6d,0x61,0x69,0x6e,
-    0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,
-    0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x6d,0x61,0x74,0x34,0x28,0x76,0x73,0x5f,0x70,
-    0x61,0x72,0x61,0x6d,0x73,0x5b,0x30,0x5d,0x2c,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,
-    0x61,0x6d,0x73,0x5b,0x31,0x5d,0x2c,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,
-    0x73,0x5b,0x32,0x5d,0x2c,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x5b,
-    0x33,0x5d,0x29,0x20,0x2a,0x20,0x76,0x65,0x63,0x34,0x28,0x70,0x6f,0x73,0x69,0x74,
-    0x69,0x6f,0x6e,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x63,
-    0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x76,0x65,0x63,0x34,0x28,0x28,0x28,0x6e,0x6f,
-    0x72,0x6d,0x61,0x6c,0x20,0x2b,0x20,0x76,0x65,0x63,0x33,0x28,0x31,0x2e,0x30,0x29,
-    0x29,0x20,0x2a,0x20,0x30,0x2e,0x35,0x29,0x20,0x2b,0x20,0x76,0x65,0x63,0x33,0x28,
-    0x39,0x2e,0x39,0x39,0x39,0x39,0x39,0x39,0x39,0x37,0x34,0x37,0x35,0x32,0x34,0x32,
-    0x37,0x30,0x37,0x38,0x37,0x38,0x33,0x35,0x31,0x32,0x31,0x31,0x35,0x34,0x37,0x38,
-    0x35,0x65,0x2d,0x30,0x37,0x20,0x2a,0x20,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,
-    0x2e,0x78,0x29,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x74,0x65,0x20,0x76,0x65,0x63,0x34,0x20,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,
+    0x3b,0x0a,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x20,0x76,0x65,0x63,0x34,
+    0x20,0x6d,0x6f,0x64,0x65,0x6c,0x30,0x3b,0x0a,0x61,0x74,0x74,0x72,0x69,0x62,0x75,
+    0x74,0x65,0x20,0x76,0x65,0x63,0x34,0x20,0x6d,0x6f,0x64,0x65,0x6c,0x31,0x3b,0x0a,
+    0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x20,0x76,0x65,0x63,0x34,0x20,0x6d,
+    0x6f,0x64,0x65,0x6c,0x32,0x3b,0x0a,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,
+    0x20,0x76,0x65,0x63,0x32,0x20,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,
+    0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x20,0x76,0x65,0x63,0x34,0x20,0x74,
+    0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x5f,0x74,0x72,0x61,0x6e,0x73,0x66,0x6f,0x72,
+    0x6d,0x3b,0x0a,0x76,0x61,0x72,0x79,0x69,0x6e,0x67,0x20,0x76,0x65,0x63,0x34,0x20,
+    0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,
+    0x20,0x76,0x65,0x63,0x34,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x3b,0x0a,0x0a,0x76,
+    0x6f,0x69,0x64,0x20,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,
+    0x20,0x76,0x65,0x63,0x34,0x20,0x6c,0x6f,0x63,0x61,0x6c,0x20,0x3d,0x20,0x76,0x65,
+    0x63,0x34,0x28,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2e,0x78,0x79,0x7a,0x2c,
+    0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,
+    0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x6d,0x61,0x74,0x34,0x28,0x76,0x73,
+    0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x5b,0x30,0x5d,0x2c,0x20,0x76,0x73,0x5f,0x70,
+    0x61,0x72,0x61,0x6d,0x73,0x5b,0x31,0x5d,0x2c,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,
+    0x61,0x6d,0x73,0x5b,0x32,0x5d,0x2c,0x20,0x76,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,
+    0x73,0x5b,0x33,0x5d,0x29,0x20,0x2a,0x20,0x76,0x65,0x63,0x34,0x28,0x64,0x6f,0x74,
+    0x28,0x6d,0x6f,0x64,0x65,0x6c,0x30,0x2c,0x20,0x6c,0x6f,0x63,0x61,0x6c,0x29,0x2c,
+    0x20,0x64,0x6f,0x74,0x28,0x6d,0x6f,0x64,0x65,0x6c,0x31,0x2c,0x20,0x6c,0x6f,0x63,
+    0x61,0x6c,0x29,0x2c,0x20,0x64,0x6f,0x74,0x28,0x6d,0x6f,0x64,0x65,0x6c,0x32,0x2c,
+    0x20,0x6c,0x6f,0x63,0x61,0x6c,0x29,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,
+    0x20,0x20,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x76,0x65,0x63,0x34,0x28,
+    0x28,0x28,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2e,0x78,0x79,0x7a,0x20,0x2b,0x20,0x76,
+    0x65,0x63,0x33,0x28,0x31,0x2e,0x30,0x29,0x29,0x20,0x2a,0x20,0x30,0x2e,0x35,0x29,
+    0x20,0x2b,0x20,0x76,0x65,0x63,0x33,0x28,0x39,0x2e,0x39,0x39,0x39,0x39,0x39,0x39,
+    0x39,0x37,0x34,0x37,0x35,0x32,0x34,0x32,0x37,0x30,0x37,0x38,0x37,0x38,0x33,0x35,
+    0x31,0x32,0x31,0x31,0x35,0x34,0x37,0x38,0x35,0x65,0x2d,0x30,0x37,0x20,0x2a,0x20,
+    0x28,0x28,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x2a,0x20,0x74,0x65,0x78,
+    0x63,0x6f,0x6f,0x72,0x64,0x5f,0x74,0x72,0x61,0x6e,0x73,0x66,0x6f,0x72,0x6d,0x2e,
+    0x78,0x79,0x29,0x20,0x2b,0x20,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x5f,0x74,
+    0x72,0x61,0x6e,0x73,0x66,0x6f,0x72,0x6d,0x2e,0x7a,0x77,0x29,0x2e,0x78,0x29,0x2c,
+    0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
 /*
     #version 100
@@ -129,7 +162,7 @@ static const char fs_source_glsl100[133] = {
 };
 static const sg_shader_desc demo_shader_desc_glsl100 = {
   0, /* _start_canary */
-  { /*attrs*/{"position","TEXCOORD",0},{"normal","TEXCOORD",1},{"texcoord","TEXCOORD",2},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}, },
+  { /*attrs*/{"position","TEXCOORD",0},{"normal","TEXCOORD",1},{"texcoord","TEXCOORD",2},{"model0","TEXCOORD",3},{"model1","TEXCOORD",4},{"model2","TEXCOORD",5},{"texcoord_transform","TEXCOORD",6},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}, },
   { /* vs */
     vs_source_glsl100, /* source */
     0,  /* bytecode */
@@ -193,7 +226,7 @@ static const sg_shader_desc demo_shader_desc_glsl100 = {
     
     struct vs_params
     {
-        float4x4 mvp;
+        float4x4 view_proj;
     };
     
     struct main0_out
@@ -204,72 +237,109 @@ static const sg_shader_desc demo_shader_desc_glsl100 = {
     
     struct main0_in
     {
-        float3 position [[attribute(0)]];
-        float3 normal [[attribute(1)]];
+        float4 position [[attribute(0)]];
+        float4 normal [[attribute(1)]];
         float2 texcoord [[attribute(2)]];
+        float4 model0 [[attribute(3)]];
+        float4 model1 [[attribute(4)]];
+        float4 model2 [[attribute(5)]];
+        float4 texcoord_transform [[attribute(6)]];
     };
     
-    #line 16 ""
-    vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& _20 [[buffer(0)]], uint gl_VertexID [[vertex_id]], uint gl_InstanceID [[instance_id]])
+    #line 24 ""
+    vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& _70 [[buffer(0)]], uint gl_VertexID [[vertex_id]], uint gl_InstanceID [[instance_id]])
     {
         main0_out out = {};
-    #line 16 ""
-        out.gl_Position = _20.mvp * float4(in.position, 1.0);
-    #line 17 ""
-        out.color = float4(((in.normal + float3(1.0)) * 0.5) + float3(9.9999999747524270787835121154785e-07 * in.texcoord.x), 1.0);
+    #line 25 ""
+        float4 local = float4(in.position.xyz, 1.0);
+    #line 26 ""
+        float3 world = float3(dot(in.model0, local), dot(in.model1, local), dot(in.model2, local));
+    #line 27 ""
+        float2 uv = (in.texcoord * in.texcoord_transform.xy) + in.texcoord_transform.zw;
+    #line 28 ""
+        out.gl_Position = _70.view_proj * float4(world, 1.0);
+    #line 29 ""
+        out.color = float4(((in.normal.xyz + float3(1.0)) * 0.5) + float3(9.9999999747524270787835121154785e-07 * uv.x), 1.0);
         return out;
     }
     
 */
-static const char vs_source_metal_macos[765] = {
+static const char vs_source_metal_macos[1188] = {
     0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,
     0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,
     0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,
     0x75,0x73,0x69,0x6e,0x67,0x20,0x6e,0x61,0x6d,0x65,0x73,0x70,0x61,0x63,0x65,0x20,
     0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x76,
     0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
-    0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x6d,0x76,0x70,0x3b,0x0a,0x7d,0x3b,0x0a,
-    0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,
-    0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,
-    0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,
-    0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
-    0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x70,
-    0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,
-    0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,0x7b,
-    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x20,0x70,0x6f,0x73,0x69,
-    0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,
-    0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
-    0x33,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
-    0x62,0x75,0x74,0x65,0x28,0x31,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
-    0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,
-    0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x32,0x29,0x5d,0x5d,0x3b,
-    0x0a,0x7d,0x3b,0x0a,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x31,0x36,0x20,0x22,0x22,
-    0x0a,0x76,0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,
-    0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,
-    0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,
-    0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,0x76,0x73,0x5f,0x70,0x61,
-    0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x32,0x30,0x20,0x5b,0x5b,0x62,0x75,0x66,0x66,
-    0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,0x75,0x69,0x6e,0x74,0x20,0x67,0x6c,
-    0x5f,0x56,0x65,0x72,0x74,0x65,0x78,0x49,0x44,0x20,0x5b,0x5b,0x76,0x65,0x72,0x74,
-    0x65,0x78,0x5f,0x69,0x64,0x5d,0x5d,0x2c,0x20,0x75,0x69,0x6e,0x74,0x20,0x67,0x6c,
-    0x5f,0x49,0x6e,0x73,0x74,0x61,0x6e,0x63,0x65,0x49,0x44,0x20,0x5b,0x5b,0x69,0x6e,
-    0x73,0x74,0x61,0x6e,0x63,0x65,0x5f,0x69,0x64,0x5d,0x5d,0x29,0x0a,0x7b,0x0a,0x20,
-    0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,0x75,0x74,
-    0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x31,0x36,0x20,
-    0x22,0x22,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,
-    0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x5f,0x32,0x30,0x2e,0x6d,0x76,0x70,
-    0x20,0x2a,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x69,0x6e,0x2e,0x70,0x6f,0x73,
-    0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x23,0x6c,0x69,
-    0x6e,0x65,0x20,0x31,0x37,0x20,0x22,0x22,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,
-    0x2e,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,
-    0x28,0x28,0x69,0x6e,0x2e,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,0x2b,0x20,0x66,0x6c,
+    0x6c,0x6f,0x61,0x74,0x34,0x78,0x34,0x20,0x76,0x69,0x65,0x77,0x5f,0x70,0x72,0x6f,
+    0x6a,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,
+    0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,
+    0x72,0x28,0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,
+    0x6f,0x6e,0x20,0x5b,0x5b,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x5d,0x5d,0x3b,
+    0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x20,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x61,0x74,0x74,
+    0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x20,0x5b,
+    0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x31,0x29,0x5d,0x5d,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,0x78,0x63,
+    0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,
+    0x28,0x32,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x20,0x6d,0x6f,0x64,0x65,0x6c,0x30,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
+    0x62,0x75,0x74,0x65,0x28,0x33,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x6d,0x6f,0x64,0x65,0x6c,0x31,0x20,0x5b,0x5b,0x61,
+    0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x34,0x29,0x5d,0x5d,0x3b,0x0a,0x20,
+    0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x6d,0x6f,0x64,0x65,0x6c,0x32,
+    0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x35,0x29,0x5d,
+    0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x74,0x65,
+    0x78,0x63,0x6f,0x6f,0x72,0x64,0x5f,0x74,0x72,0x61,0x6e,0x73,0x66,0x6f,0x72,0x6d,
+    0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x36,0x29,0x5d,
+    0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x32,0x34,0x20,
+    0x22,0x22,0x0a,0x76,0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,
+    0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,
+    0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,
+    0x5d,0x5d,0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,0x76,0x73,0x5f,
+    0x70,0x61,0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x37,0x30,0x20,0x5b,0x5b,0x62,0x75,
+    0x66,0x66,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,0x75,0x69,0x6e,0x74,0x20,
+    0x67,0x6c,0x5f,0x56,0x65,0x72,0x74,0x65,0x78,0x49,0x44,0x20,0x5b,0x5b,0x76,0x65,
+    0x72,0x74,0x65,0x78,0x5f,0x69,0x64,0x5d,0x5d,0x2c,0x20,0x75,0x69,0x6e,0x74,0x20,
+    0x67,0x6c,0x5f,0x49,0x6e,0x73,0x74,0x61,0x6e,0x63,0x65,0x49,0x44,0x20,0x5b,0x5b,
+    0x69,0x6e,0x73,0x74,0x61,0x6e,0x63,0x65,0x5f,0x69,0x64,0x5d,0x5d,0x29,0x0a,0x7b,
+    0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,
+    0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x32,
+    0x35,0x20,0x22,0x22,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,
+    0x6c,0x6f,0x63,0x61,0x6c,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x69,
+    0x6e,0x2e,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2e,0x78,0x79,0x7a,0x2c,0x20,
+    0x31,0x2e,0x30,0x29,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x32,0x36,0x20,0x22,
+    0x22,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x20,0x77,0x6f,0x72,
+    0x6c,0x64,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x28,0x64,0x6f,0x74,0x28,
+    0x69,0x6e,0x2e,0x6d,0x6f,0x64,0x65,0x6c,0x30,0x2c,0x20,0x6c,0x6f,0x63,0x61,0x6c,
+    0x29,0x2c,0x20,0x64,0x6f,0x74,0x28,0x69,0x6e,0x2e,0x6d,0x6f,0x64,0x65,0x6c,0x31,
+    0x2c,0x20,0x6c,0x6f,0x63,0x61,0x6c,0x29,0x2c,0x20,0x64,0x6f,0x74,0x28,0x69,0x6e,
+    0x2e,0x6d,0x6f,0x64,0x65,0x6c,0x32,0x2c,0x20,0x6c,0x6f,0x63,0x61,0x6c,0x29,0x29,
+    0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x32,0x37,0x20,0x22,0x22,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x75,0x76,0x20,0x3d,0x20,0x28,0x69,
+    0x6e,0x2e,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x20,0x2a,0x20,0x69,0x6e,0x2e,
+    0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x5f,0x74,0x72,0x61,0x6e,0x73,0x66,0x6f,
+    0x72,0x6d,0x2e,0x78,0x79,0x29,0x20,0x2b,0x20,0x69,0x6e,0x2e,0x74,0x65,0x78,0x63,
+    0x6f,0x6f,0x72,0x64,0x5f,0x74,0x72,0x61,0x6e,0x73,0x66,0x6f,0x72,0x6d,0x2e,0x7a,
+    0x77,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x32,0x38,0x20,0x22,0x22,0x0a,0x20,
+    0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,
+    0x6f,0x6e,0x20,0x3d,0x20,0x5f,0x37,0x30,0x2e,0x76,0x69,0x65,0x77,0x5f,0x70,0x72,
+    0x6f,0x6a,0x20,0x2a,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x77,0x6f,0x72,0x6c,
+    0x64,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x23,0x6c,0x69,0x6e,0x65,0x20,0x32,
+    0x39,0x20,0x22,0x22,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x63,0x6f,0x6c,
+    0x6f,0x72,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x28,0x28,0x69,0x6e,
+    0x2e,0x6e,0x6f,0x72,0x6d,0x61,0x6c,0x2e,0x78,0x79,0x7a,0x20,0x2b,0x20,0x66,0x6c,
     0x6f,0x61,0x74,0x33,0x28,0x31,0x2e,0x30,0x29,0x29,0x20,0x2a,0x20,0x30,0x2e,0x35,
     0x29,0x20,0x2b,0x20,0x66,0x6c,0x6f,0x61,0x74,0x33,0x28,0x39,0x2e,0x39,0x39,0x39,
     0x39,0x39,0x39,0x39,0x37,0x34,0x37,0x35,0x32,0x34,0x32,0x37,0x30,0x37,0x38,0x37,
     0x38,0x33,0x35,0x31,0x32,0x31,0x31,0x35,0x34,0x37,0x38,0x35,0x65,0x2d,0x30,0x37,
-    0x20,0x2a,0x20,0x69,0x6e,0x2e,0x74,0x65,0x78,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x78,
-    0x29,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,
-    0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x20,0x2a,0x20,0x75,0x76,0x2e,0x78,0x29,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,
+    0x20,0x20,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,
+    0x7d,0x0a,0x0a,0x00,
 };
 /*
     #include <metal_stdlib>
@@ -323,7 +393,7 @@ static const char fs_source_metal_macos[337] = {
 };
 static const sg_shader_desc demo_shader_desc_metal_macos = {
   0, /* _start_canary */
-  { /*attrs*/{"position","TEXCOORD",0},{"normal","TEXCOORD",1},{"texcoord","TEXCOORD",2},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}, },
+  { /*attrs*/{"position","TEXCOORD",0},{"normal","TEXCOORD",1},{"texcoord","TEXCOORD",2},{"model0","TEXCOORD",3},{"model1","TEXCOORD",4},{"model2","TEXCOORD",5},{"texcoord_transform","TEXCOORD",6},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}, },
   { /* vs */
     vs_source_metal_macos, /* source */
     0,  /* bytecode */
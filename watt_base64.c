@@ -0,0 +1,233 @@
+#include "watt_base64.h"
+
+#define BASE64_INVALID 0xff
+
+#define BASE64_DECODER_SCALAR 0
+#define BASE64_DECODER_SSSE3 1
+#define BASE64_DECODER_AVX2 2
+
+/* 6 bit value of every byte, BASE64_INVALID outside the alphabet */
+static const uint8_t base64_values[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 62,   0xff, 0xff, 0xff, 63,
+	52,   53,   54,   55,   56,   57,   58,   59,   60,   61,   0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0,    1,    2,    3,    4,    5,    6,    7,    8,    9,    10,   11,   12,   13,   14,
+	15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25,   0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+	41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51,   0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+/*
+ * the vector decoders classify every character by its high and low nibble:
+ * lut_lo/lut_hi hold bit sets whose intersection is empty exactly for the
+ * alphabet, and lut_roll the offset from the ascii code to the 6 bit value
+ * for each high nibble ('/' shares its nibble with '+' and is rolled apart
+ * by the comparison). two multiply-adds then merge four 6 bit values into
+ * 24 bits and a shuffle drops the zero byte of every 32 bit lane.
+ */
+
+/*
+ * with gcc or clang on x86 the block decoders are built for their
+ * instruction sets whatever the compiler flags, and base64_decoder_init
+ * picks the widest one the cpu runs. elsewhere they follow the flags.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_DISPATCH 1
+#define BASE64_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BASE64_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BASE64_TARGET_SSSE3
+#define BASE64_TARGET_AVX2
+#endif
+
+#if defined(BASE64_DISPATCH) || defined(__SSSE3__)
+#define BASE64_SSSE3 1
+#include <tmmintrin.h> /* SSSE3 */
+
+/* decodes 16 characters into 12 bytes, writes 16 */
+BASE64_TARGET_SSSE3 static int32_t base64_decode_x16_ssse3(uint8_t *out, const char *text)
+{
+	__m128i in, hi_nibbles, lo_nibbles, lo, hi, roll, values, merged;
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i nibble_mask = _mm_set1_epi8(0x0f);
+
+	in = _mm_loadu_si128((const __m128i *)text);
+	hi_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), nibble_mask);
+	lo_nibbles = _mm_and_si128(in, nibble_mask);
+	lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+	hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+	if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) {
+		return 0;
+	}
+
+	roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(in, _mm_set1_epi8('/')), hi_nibbles));
+	values = _mm_add_epi8(in, roll);
+	merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+	merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+	merged = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	_mm_storeu_si128((__m128i *)out, merged);
+	return 1;
+}
+
+/* decodes blocks from byte *decoded on while their stores fit in size, advances *decoded */
+BASE64_TARGET_SSSE3 static int32_t base64_decode_blocks_ssse3(uint8_t *out, size_t size, const char *text, size_t *decoded)
+{
+	size_t i;
+
+	for (i = *decoded; i + 16 <= size; i += 12) {
+		if (!base64_decode_x16_ssse3(out + i, text + i / 3 * 4)) {
+			return 0;
+		}
+	}
+	*decoded = i;
+	return 1;
+}
+#endif
+
+#if defined(BASE64_DISPATCH) || defined(__AVX2__)
+#define BASE64_AVX2 1
+#include <immintrin.h> /* AVX2 */
+
+/* decodes 32 characters into 24 bytes, writes 32 */
+BASE64_TARGET_AVX2 static int32_t base64_decode_x32_avx2(uint8_t *out, const char *text)
+{
+	__m256i in, hi_nibbles, lo_nibbles, lo, hi, roll, values, merged;
+	const __m256i lut_lo = _mm256_setr_epi8(
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m256i lut_hi = _mm256_setr_epi8(
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+
+	in = _mm256_loadu_si256((const __m256i *)text);
+	hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), nibble_mask);
+	lo_nibbles = _mm256_and_si256(in, nibble_mask);
+	lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+	hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+	if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256()))) {
+		return 0;
+	}
+
+	roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, _mm256_set1_epi8('/')), hi_nibbles));
+	values = _mm256_add_epi8(in, roll);
+	merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+	merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+	merged = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	/* the shuffle works per 128 bit lane, close the gap between the lanes */
+	merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+	_mm256_storeu_si256((__m256i *)out, merged);
+	return 1;
+}
+
+/* like base64_decode_blocks_ssse3 */
+BASE64_TARGET_AVX2 static int32_t base64_decode_blocks_avx2(uint8_t *out, size_t size, const char *text, size_t *decoded)
+{
+	size_t i;
+
+	for (i = *decoded; i + 32 <= size; i += 24) {
+		if (!base64_decode_x32_avx2(out + i, text + i / 3 * 4)) {
+			return 0;
+		}
+	}
+	*decoded = i;
+	return 1;
+}
+#endif
+
+#if defined(__AVX2__)
+static int32_t base64_decoder = BASE64_DECODER_AVX2;
+#elif defined(__SSSE3__)
+static int32_t base64_decoder = BASE64_DECODER_SSSE3;
+#else
+static int32_t base64_decoder = BASE64_DECODER_SCALAR;
+#endif
+
+#if defined(BASE64_DISPATCH)
+/* picks the block decoder before main, so it never changes while loader threads decode */
+__attribute__((constructor)) static void base64_decoder_init(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		base64_decoder = BASE64_DECODER_AVX2;
+	} else if (__builtin_cpu_supports("ssse3")) {
+		base64_decoder = BASE64_DECODER_SSSE3;
+	} else {
+		base64_decoder = BASE64_DECODER_SCALAR;
+	}
+}
+#endif
+
+int32_t base64_decode(uint8_t *out, size_t size, const char *text)
+{
+	size_t i = 0;
+	uint32_t bits, value, a, b, c, d;
+	int32_t bit_count;
+
+	/* the block decoders store a full register, keep that inside out */
+#if defined(BASE64_AVX2)
+	if (base64_decoder >= BASE64_DECODER_AVX2 && !base64_decode_blocks_avx2(out, size, text, &i)) {
+		return 0;
+	}
+#endif
+#if defined(BASE64_SSSE3)
+	if (base64_decoder >= BASE64_DECODER_SSSE3 && !base64_decode_blocks_ssse3(out, size, text, &i)) {
+		return 0;
+	}
+#endif
+	text += i / 3 * 4;
+	for (; i + 3 <= size; i += 3, text += 4) {
+		a = base64_values[(uint8_t)text[0]];
+		b = base64_values[(uint8_t)text[1]];
+		c = base64_values[(uint8_t)text[2]];
+		d = base64_values[(uint8_t)text[3]];
+		/* valid values fit in 6 bits, BASE64_INVALID does not */
+		if ((a | b | c | d) & 0xc0) {
+			return 0;
+		}
+		bits = (a << 18) | (b << 12) | (c << 6) | d;
+		out[i] = (uint8_t)(bits >> 16);
+		out[i + 1] = (uint8_t)(bits >> 8);
+		out[i + 2] = (uint8_t)bits;
+	}
+
+	/* one or two bytes left, from the first two or three characters of a quantum */
+	bits = 0;
+	bit_count = 0;
+	for (; i < size; ++i) {
+		while (bit_count < 8) {
+			value = base64_values[(uint8_t)*text++];
+			if (value == BASE64_INVALID) {
+				return 0;
+			}
+			bits = (bits << 6) | value;
+			bit_count += 6;
+		}
+		out[i] = (uint8_t)(bits >> (bit_count - 8));
+		bit_count -= 8;
+	}
+	return 1;
+}
+
+const char *base64_decoder_name(void)
+{
+	static const char *const names[] = {"scalar", "ssse3", "avx2"};
+
+	return names[base64_decoder];
+}
@@ -0,0 +1,22 @@
+#ifndef WATT_BASE64_H
+#define WATT_BASE64_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * decodes the first size bytes of standard (+/) base64 text into out.
+ * text must hold at least (size * 4 + 2) / 3 characters, padding after
+ * them is ignored. returns 0 when a character outside the alphabet is met.
+ *
+ * blocks of 32 (AVX2) or 16 (SSSE3) characters are translated and packed
+ * in vector registers, the tail and cpus without either instruction set go
+ * through a lookup table. on x86 with gcc or clang the instruction set is
+ * picked at run time, so builds without -march still use the vector paths.
+ */
+int32_t base64_decode(uint8_t *out, size_t size, const char *text);
+
+/* name of the widest block decoder in use, for benchmarks */
+const char *base64_decoder_name(void);
+
+#endif
@@ -1,15 +1,24 @@
 #include "watt_buffer.h"
 
-#include <stdlib.h> /* calloc, free */
-#include <fcntl.h>	/* open */
-#include <unistd.h> /* read, close */
+#include <stdlib.h>   /* calloc, malloc, realloc, free, posix_memalign */
+#include <stdint.h>   /* SIZE_MAX */
+#include <errno.h>    /* errno, EINTR */
+#include <fcntl.h>    /* open */
+#include <unistd.h>   /* read, close */
+#include <sys/mman.h> /* mmap, madvise, munmap */
 #include <sys/stat.h> /* fstat */
-#include <string.h> /* memset */
-#include <assert.h> /* assert */
+#include <string.h>   /* memset */
+#include <assert.h>   /* assert */
 
-struct buffer buffer_create(uint32_t size)
+/* largest single read(), some systems reject or truncate larger ones */
+#define BUFFER_READ_CHUNK_SIZE (1u << 30)
+
+struct buffer buffer_create(uint64_t size)
 {
 	struct buffer result = {0};
+	if (size > SIZE_MAX) {
+		return result;
+	}
 	result.data = calloc((size_t)size, 1);
 	if (result.data) {
 		result.size = size;
@@ -17,46 +26,222 @@ struct buffer buffer_create(uint32_t size)
 	return result;
 }
 
+/* size of an open regular file, 0 when it is empty or not a regular file */
+static uint64_t file_size(int file)
+{
+	struct stat desc;
+	if (fstat(file, &desc) != 0 || !S_ISREG(desc.st_mode) || desc.st_size <= 0) {
+		return 0;
+	}
+	if ((uint64_t)desc.st_size > SIZE_MAX) {
+		return 0;
+	}
+	return (uint64_t)desc.st_size;
+}
+
+static struct buffer read_file(int file, uint64_t size)
+{
+	struct buffer result = {0};
+	uint64_t offset, chunk;
+	ssize_t count;
+
+	/* every byte is overwritten, no need to zero it first */
+	result.data = malloc((size_t)size);
+	if (!result.data) {
+		return result;
+	}
+	result.size = size;
+
+	offset = 0;
+	while (offset < size) {
+		chunk = size - offset;
+		chunk = (chunk > BUFFER_READ_CHUNK_SIZE) ? BUFFER_READ_CHUNK_SIZE : chunk;
+		count = read(file, (uint8_t *)result.data + offset, (size_t)chunk);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			/* error, or the file shrank since fstat */
+			buffer_destroy(&result);
+			return result;
+		}
+		offset += (uint64_t)count;
+	}
+	return result;
+}
+
 struct buffer buffer_create_from_file(const char *filename)
 {
 	struct buffer result = {0};
+	uint64_t size;
+	int file;
 
-	int file = open(filename, O_RDONLY);
+	file = open(filename, O_RDONLY);
 	if (file < 0) {
 		return result;
 	}
+	size = file_size(file);
+	if (size > 0) {
+		result = read_file(file, size);
+	}
+	close(file);
+	return result;
+}
 
-	struct stat desc;
-	if (!(fstat(file, &desc) == 0 && desc.st_size > 0)) {
-		close(file);
+struct buffer buffer_map_file(const char *filename)
+{
+	struct buffer result = {0};
+	uint64_t size;
+	void *data;
+	int file;
+
+	file = open(filename, O_RDONLY);
+	if (file < 0) {
 		return result;
 	}
-
-	result = buffer_create(desc.st_size);
-	if (result.size == 0) {
+	size = file_size(file);
+	if (size == 0) {
 		close(file);
 		return result;
 	}
 
-	ssize_t size = read(file, result.data, (size_t)result.size);
-	if (size != (ssize_t)result.size) {
-		buffer_destroy(&result);
+	data = mmap(0, (size_t)size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (data == MAP_FAILED) {
+		result = read_file(file, size);
+		close(file);
+		return result;
 	}
-
+	/* the mapping keeps the file referenced */
 	close(file);
+
+	madvise(data, (size_t)size, MADV_SEQUENTIAL);
+	madvise(data, (size_t)size, MADV_WILLNEED);
+	result.data = data;
+	result.size = size;
+	result.mapped = 1;
 	return result;
 }
 
 void buffer_clear(struct buffer *buf)
 {
-	assert(buf && buf->data);
-	memset(buf->data, 0, buf->size);
+	assert(buf && buf->data && !buf->mapped);
+	memset(buf->data, 0, (size_t)buf->size);
 }
 
 void buffer_destroy(struct buffer *buf)
 {
 	assert(buf && buf->data);
-	free(buf->data);
+	if (buf->mapped) {
+		munmap(buf->data, (size_t)buf->size);
+	} else {
+		free(buf->data);
+	}
 	buf->data = 0;
 	buf->size = 0;
+	buf->mapped = 0;
+}
+
+int32_t buffer_arena_create(struct buffer_arena *arena, uint64_t capacity)
+{
+	assert(arena);
+	memset(arena, 0, sizeof(*arena));
+	if (capacity == 0) {
+		return 1;
+	}
+	arena->buffer = buffer_create(capacity);
+	return arena->buffer.data != 0;
+}
+
+void *buffer_arena_push(struct buffer_arena *arena, uint64_t size, uint64_t alignment)
+{
+	struct buffer_arena_overflow *overflow;
+	uintptr_t base, aligned;
+	void *data;
+	int32_t capacity;
+
+	assert(arena);
+	alignment = (alignment == 0) ? BUFFER_ARENA_ALIGNMENT : alignment;
+	assert((alignment & (alignment - 1)) == 0);
+	++arena->push_count;
+	arena->push_bytes += size;
+
+	if (arena->buffer.data) {
+		base = (uintptr_t)arena->buffer.data;
+		aligned = (base + (uintptr_t)arena->used + (uintptr_t)(alignment - 1)) & ~(uintptr_t)(alignment - 1);
+		if ((uint64_t)(aligned - base) + size <= arena->buffer.size) {
+			arena->used = (uint64_t)(aligned - base) + size;
+			arena->peak = (arena->used + arena->overflow_size > arena->peak) ? arena->used + arena->overflow_size : arena->peak;
+			return (void *)aligned;
+		}
+	}
+
+	/* doesn't fit, give the push its own block until the reset that releases it */
+	if (arena->overflow_count == arena->overflow_capacity) {
+		capacity = (arena->overflow_capacity > 0) ? arena->overflow_capacity * 2 : 8;
+		overflow = realloc(arena->overflow, (size_t)capacity * sizeof(struct buffer_arena_overflow));
+		if (!overflow) {
+			return 0;
+		}
+		arena->overflow = overflow;
+		arena->overflow_capacity = capacity;
+	}
+	if (size > SIZE_MAX || posix_memalign(&data, (alignment > sizeof(void *)) ? (size_t)alignment : sizeof(void *), (size_t)size) != 0) {
+		return 0;
+	}
+	arena->overflow[arena->overflow_count].data = data;
+	/* the grown buffer may need the alignment padding too */
+	arena->overflow[arena->overflow_count].size = size + alignment;
+	arena->overflow_size += size + alignment;
+	++arena->overflow_count;
+	++arena->overflow_push_count;
+	arena->peak = (arena->used + arena->overflow_size > arena->peak) ? arena->used + arena->overflow_size : arena->peak;
+	return data;
+}
+
+struct buffer_arena_mark buffer_arena_mark(const struct buffer_arena *arena)
+{
+	struct buffer_arena_mark mark;
+
+	assert(arena);
+	mark.used = arena->used;
+	mark.overflow_count = arena->overflow_count;
+	return mark;
+}
+
+void buffer_arena_reset(struct buffer_arena *arena, struct buffer_arena_mark mark)
+{
+	struct buffer grown;
+
+	assert(arena && mark.used <= arena->used && mark.overflow_count <= arena->overflow_count);
+	while (arena->overflow_count > mark.overflow_count) {
+		--arena->overflow_count;
+		free(arena->overflow[arena->overflow_count].data);
+		arena->overflow_size -= arena->overflow[arena->overflow_count].size;
+	}
+	arena->used = mark.used;
+
+	/* empty again, grow to the high-water mark so the same pushes fit next time */
+	if (arena->used == 0 && arena->overflow_count == 0 && arena->peak > arena->buffer.size) {
+		grown = buffer_create(arena->peak);
+		if (grown.data) {
+			if (arena->buffer.data) {
+				buffer_destroy(&arena->buffer);
+			}
+			arena->buffer = grown;
+		}
+	}
+}
+
+void buffer_arena_destroy(struct buffer_arena *arena)
+{
+	struct buffer_arena_mark empty = {0, 0};
+
+	assert(arena);
+	arena->peak = 0;
+	buffer_arena_reset(arena, empty);
+	if (arena->buffer.data) {
+		buffer_destroy(&arena->buffer);
+	}
+	free(arena->overflow);
+	memset(arena, 0, sizeof(*arena));
 }
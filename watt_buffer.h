@@ -5,11 +5,70 @@
 
 struct buffer {
 	void *data;
-	uint32_t size;
+	uint64_t size;
+	int32_t mapped; /* data is a read only file mapping, buffer_destroy unmaps instead of freeing */
 };
 
-struct buffer buffer_create(uint32_t size);
+struct buffer buffer_create(uint64_t size);
+
+/* reads a whole file into heap memory, an empty buffer when it is missing, empty or unreadable */
 struct buffer buffer_create_from_file(const char *filename);
+
+/*
+ * maps a whole file read only, hinting the kernel to read ahead as it is
+ * consumed front to back. falls back to buffer_create_from_file where the
+ * file can't be mapped.
+ */
+struct buffer buffer_map_file(const char *filename);
+
 void buffer_destroy(struct buffer *buf);
 
+/*
+ * bump allocator over a buffer
+ *
+ * pushes hand out aligned ranges of the buffer and are released together
+ * by resetting to a mark taken earlier. a push that doesn't fit falls back
+ * to its own heap block, freed by the reset that releases it, and the next
+ * reset to an empty arena grows the buffer to the high-water mark, so a
+ * steady workload stops touching the heap after its first round.
+ */
+
+#define BUFFER_ARENA_ALIGNMENT 16
+
+struct buffer_arena_mark {
+	uint64_t used;
+	int32_t overflow_count;
+};
+
+struct buffer_arena_overflow {
+	void *data;
+	uint64_t size;
+};
+
+struct buffer_arena {
+	struct buffer buffer;
+	uint64_t used;
+	uint64_t overflow_size; /* bytes in live overflow blocks */
+	uint64_t peak;          /* most bytes live at once, buffer plus overflow */
+	struct buffer_arena_overflow *overflow;
+	int32_t overflow_count;
+	int32_t overflow_capacity;
+	/* counters for benchmarks, never reset by the arena */
+	uint64_t push_count;
+	uint64_t push_bytes;
+	uint64_t overflow_push_count;
+};
+
+int32_t buffer_arena_create(struct buffer_arena *arena, uint64_t capacity);
+
+/* alignment is a power of two, 0 picks BUFFER_ARENA_ALIGNMENT. returns 0 only when the heap is exhausted */
+void *buffer_arena_push(struct buffer_arena *arena, uint64_t size, uint64_t alignment);
+
+struct buffer_arena_mark buffer_arena_mark(const struct buffer_arena *arena);
+
+/* releases every push made since mark */
+void buffer_arena_reset(struct buffer_arena *arena, struct buffer_arena_mark mark);
+
+void buffer_arena_destroy(struct buffer_arena *arena);
+
 #endif
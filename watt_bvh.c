@@ -0,0 +1,295 @@
+#include "watt_bvh.h"
+#include "watt_math.h"
+
+#include <math.h>   /* INFINITY */
+#include <stdlib.h> /* realloc, free */
+#include <string.h> /* memset, memcmp */
+#include <assert.h> /* assert */
+
+static struct aabb item_bounds(struct vec3_soa center, struct vec3_soa extent, int32_t item)
+{
+	struct aabb result;
+	result.min = v3(center.x[item] - extent.x[item], center.y[item] - extent.y[item], center.z[item] - extent.z[item]);
+	result.max = v3(center.x[item] + extent.x[item], center.y[item] + extent.y[item], center.z[item] + extent.z[item]);
+	return result;
+}
+
+/* recomputes the bounds of one node from its items (leaves) or its children */
+static void refit_node(struct bvh *bvh, int32_t node_idx, struct vec3_soa center, struct vec3_soa extent)
+{
+	struct bvh_node *node;
+	int32_t i;
+
+	node = &bvh->nodes[node_idx];
+	if (node->left) {
+		node->bounds = aabb_union(bvh->nodes[node->left].bounds, bvh->nodes[node->right].bounds);
+		return;
+	}
+	node->bounds = item_bounds(center, extent, bvh->items[node->first]);
+	for (i = node->first + 1; i < node->first + node->count; ++i) {
+		node->bounds = aabb_union(node->bounds, item_bounds(center, extent, bvh->items[i]));
+	}
+}
+
+static int32_t bvh_reserve(struct bvh *bvh, int32_t count)
+{
+	int32_t node_capacity;
+	void *items, *item_leaves, *nodes, *stack;
+
+	if (count > bvh->item_capacity) {
+		items = realloc(bvh->items, (size_t)count * sizeof(int32_t));
+		if (!items) {
+			return 0;
+		}
+		bvh->items = items;
+		item_leaves = realloc(bvh->item_leaves, (size_t)count * sizeof(int32_t));
+		if (!item_leaves) {
+			return 0;
+		}
+		bvh->item_leaves = item_leaves;
+		bvh->item_capacity = count;
+	}
+
+	/* every leaf holds at least one item, so a binary tree has at most 2n - 1 nodes */
+	node_capacity = (count > 0) ? count * 2 : 1;
+	if (node_capacity > bvh->node_capacity) {
+		nodes = realloc(bvh->nodes, (size_t)node_capacity * sizeof(struct bvh_node));
+		if (!nodes) {
+			return 0;
+		}
+		bvh->nodes = nodes;
+		stack = realloc(bvh->stack, (size_t)node_capacity * sizeof(int32_t));
+		if (!stack) {
+			return 0;
+		}
+		bvh->stack = stack;
+		bvh->node_capacity = node_capacity;
+	}
+	return 1;
+}
+
+static int32_t add_node(struct bvh *bvh, int32_t first, int32_t count, int32_t parent)
+{
+	struct bvh_node *node;
+	int32_t node_idx;
+
+	assert(bvh->node_count < bvh->node_capacity);
+	node_idx = bvh->node_count++;
+	node = &bvh->nodes[node_idx];
+	memset(node, 0, sizeof(*node));
+	node->first = first;
+	node->count = count;
+	node->parent = parent;
+	return node_idx;
+}
+
+int32_t bvh_build(struct bvh *bvh, struct vec3_soa center, struct vec3_soa extent, int32_t count)
+{
+	struct bvh_node *node;
+	const float *axis_center;
+	float lo[3], hi[3], c[3], split;
+	int32_t stack_count, node_idx, axis, left_count, first, last, i, j, tmp;
+
+	assert(bvh && count >= 0);
+	if (!bvh_reserve(bvh, count)) {
+		return 0;
+	}
+	bvh->item_count = count;
+	bvh->node_count = 0;
+	for (i = 0; i < count; ++i) {
+		bvh->items[i] = i;
+	}
+	if (count == 0) {
+		return 1;
+	}
+
+	stack_count = 0;
+	bvh->stack[stack_count++] = add_node(bvh, 0, count, -1);
+	while (stack_count > 0) {
+		node_idx = bvh->stack[--stack_count];
+		node = &bvh->nodes[node_idx];
+		first = node->first;
+		last = node->first + node->count - 1;
+
+		if (node->count <= BVH_LEAF_SIZE) {
+			for (i = first; i <= last; ++i) {
+				bvh->item_leaves[bvh->items[i]] = node_idx;
+			}
+			continue;
+		}
+
+		/* split the longest axis of the item centers at its midpoint */
+		lo[0] = hi[0] = center.x[bvh->items[first]];
+		lo[1] = hi[1] = center.y[bvh->items[first]];
+		lo[2] = hi[2] = center.z[bvh->items[first]];
+		for (i = first + 1; i <= last; ++i) {
+			c[0] = center.x[bvh->items[i]];
+			c[1] = center.y[bvh->items[i]];
+			c[2] = center.z[bvh->items[i]];
+			for (j = 0; j < 3; ++j) {
+				lo[j] = (c[j] < lo[j]) ? c[j] : lo[j];
+				hi[j] = (c[j] > hi[j]) ? c[j] : hi[j];
+			}
+		}
+		axis = 0;
+		if (hi[1] - lo[1] > hi[axis] - lo[axis]) {
+			axis = 1;
+		}
+		if (hi[2] - lo[2] > hi[axis] - lo[axis]) {
+			axis = 2;
+		}
+		axis_center = (axis == 0) ? center.x : (axis == 1) ? center.y : center.z;
+		split = (lo[axis] + hi[axis]) * 0.5f;
+
+		i = first;
+		j = last;
+		while (i <= j) {
+			if (axis_center[bvh->items[i]] < split) {
+				++i;
+			} else {
+				tmp = bvh->items[i];
+				bvh->items[i] = bvh->items[j];
+				bvh->items[j] = tmp;
+				--j;
+			}
+		}
+		left_count = i - first;
+		if (left_count == 0 || left_count == node->count) {
+			/* all centers coincide on the axis, any split is as good as another */
+			left_count = node->count / 2;
+		}
+
+		node->left = add_node(bvh, first, left_count, node_idx);
+		node->right = add_node(bvh, first + left_count, node->count - left_count, node_idx);
+		bvh->stack[stack_count++] = node->right;
+		bvh->stack[stack_count++] = node->left;
+	}
+
+	bvh_refit(bvh, center, extent);
+	return 1;
+}
+
+/* refits the leaf of one moved item and its ancestors, stops once a node's bounds stay the same */
+void bvh_refit_item(struct bvh *bvh, int32_t item, struct vec3_soa center, struct vec3_soa extent)
+{
+	struct aabb old_bounds;
+	int32_t node_idx;
+
+	assert(bvh && item >= 0 && item < bvh->item_count);
+	node_idx = bvh->item_leaves[item];
+	while (node_idx >= 0) {
+		old_bounds = bvh->nodes[node_idx].bounds;
+		refit_node(bvh, node_idx, center, extent);
+		if (memcmp(&old_bounds, &bvh->nodes[node_idx].bounds, sizeof(old_bounds)) == 0) {
+			break;
+		}
+		node_idx = bvh->nodes[node_idx].parent;
+	}
+}
+
+/* refits every node, children are stored after their parent */
+void bvh_refit(struct bvh *bvh, struct vec3_soa center, struct vec3_soa extent)
+{
+	int32_t i;
+
+	assert(bvh);
+	for (i = bvh->node_count - 1; i >= 0; --i) {
+		refit_node(bvh, i, center, extent);
+	}
+}
+
+int32_t bvh_cull(struct bvh *bvh, uint8_t *visible, struct frustum f, struct vec3_soa center, struct vec3_soa extent)
+{
+	struct bvh_node *node;
+	struct vec3 node_center, node_extent;
+	int32_t stack_count, visible_count, item, i;
+
+	assert(bvh);
+	memset(visible, 0, (size_t)bvh->item_count);
+	if (bvh->node_count == 0) {
+		return 0;
+	}
+
+	visible_count = 0;
+	stack_count = 0;
+	bvh->stack[stack_count++] = 0;
+	while (stack_count > 0) {
+		node = &bvh->nodes[bvh->stack[--stack_count]];
+		node_center = vec3_scale(vec3_add(node->bounds.min, node->bounds.max), 0.5f);
+		node_extent = vec3_scale(vec3_add(node->bounds.max, vec3_scale(node->bounds.min, -1.0f)), 0.5f);
+
+		switch (frustum_classify_aabb(f, node_center, node_extent)) {
+		case FRUSTUM_OUTSIDE:
+			break;
+		case FRUSTUM_INSIDE:
+			for (i = node->first; i < node->first + node->count; ++i) {
+				visible[bvh->items[i]] = 1;
+			}
+			visible_count += node->count;
+			break;
+		default:
+			if (node->left) {
+				bvh->stack[stack_count++] = node->right;
+				bvh->stack[stack_count++] = node->left;
+				break;
+			}
+			for (i = node->first; i < node->first + node->count; ++i) {
+				item = bvh->items[i];
+				visible[item] = (uint8_t)frustum_test_aabb(f, v3(center.x[item], center.y[item], center.z[item]), v3(extent.x[item], extent.y[item], extent.z[item]));
+				visible_count += visible[item];
+			}
+			break;
+		}
+	}
+	return visible_count;
+}
+
+int32_t bvh_raycast(struct bvh *bvh, struct vec3 origin, struct vec3 direction, struct vec3_soa center, struct vec3_soa extent, float *distance)
+{
+	struct bvh_node *node;
+	float best_distance, hit_distance;
+	int32_t stack_count, best_item, item, i;
+
+	assert(bvh);
+	best_item = BVH_INVALID_ITEM;
+	best_distance = INFINITY;
+	if (bvh->node_count == 0) {
+		return best_item;
+	}
+
+	stack_count = 0;
+	bvh->stack[stack_count++] = 0;
+	while (stack_count > 0) {
+		node = &bvh->nodes[bvh->stack[--stack_count]];
+		if (!ray_intersect_aabb(origin, direction, node->bounds, best_distance, &hit_distance)) {
+			continue;
+		}
+		if (node->left) {
+			bvh->stack[stack_count++] = node->right;
+			bvh->stack[stack_count++] = node->left;
+			continue;
+		}
+		for (i = node->first; i < node->first + node->count; ++i) {
+			item = bvh->items[i];
+			if (ray_intersect_aabb(origin, direction, item_bounds(center, extent, item), best_distance, &hit_distance) && hit_distance < best_distance) {
+				best_item = item;
+				best_distance = hit_distance;
+			}
+		}
+	}
+
+	if (best_item != BVH_INVALID_ITEM && distance) {
+		*distance = best_distance;
+	}
+	return best_item;
+}
+
+void bvh_destroy(struct bvh *bvh)
+{
+	assert(bvh);
+	free(bvh->nodes);
+	free(bvh->items);
+	free(bvh->item_leaves);
+	free(bvh->stack);
+	memset(bvh, 0, sizeof(*bvh));
+}
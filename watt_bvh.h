@@ -0,0 +1,52 @@
+#ifndef WATT_BVH_H
+#define WATT_BVH_H
+
+#include "watt_math_types.h"
+
+/*
+ * bounding volume hierarchy over boxes given as center/extent streams
+ *
+ * items are the stream indices. the tree is built top-down, splitting the
+ * longest axis of the item centers at its midpoint, and every node covers a
+ * contiguous range of bvh.items so a subtree can be visited as a plain
+ * array. moved items are refit in place, the tree is only rebuilt when
+ * items are added or removed. children are always stored after their
+ * parent, so walking nodes backwards visits children first.
+ */
+
+#define BVH_LEAF_SIZE 4
+#define BVH_INVALID_ITEM -1
+
+struct bvh_node {
+	struct aabb bounds;
+	int32_t first;  /* first bvh.items entry of the subtree */
+	int32_t count;  /* number of items in the subtree */
+	int32_t left;   /* child nodes, 0 for leaves (the root is never a child) */
+	int32_t right;
+	int32_t parent; /* -1 for the root */
+};
+
+struct bvh {
+	struct bvh_node *nodes;
+	int32_t *items;       /* item indices in subtree order */
+	int32_t *item_leaves; /* item index -> leaf node */
+	int32_t *stack;       /* traversal scratch, node_capacity entries */
+	int32_t node_count;
+	int32_t node_capacity;
+	int32_t item_count;
+	int32_t item_capacity;
+};
+
+int32_t bvh_build(struct bvh *bvh, struct vec3_soa center, struct vec3_soa extent, int32_t count);
+void bvh_refit_item(struct bvh *bvh, int32_t item, struct vec3_soa center, struct vec3_soa extent);
+void bvh_refit(struct bvh *bvh, struct vec3_soa center, struct vec3_soa extent);
+
+/* writes 0/1 per item to visible and returns the visible count, like frustum_cull_soa */
+int32_t bvh_cull(struct bvh *bvh, uint8_t *visible, struct frustum f, struct vec3_soa center, struct vec3_soa extent);
+
+/* nearest item whose box the ray hits, or BVH_INVALID_ITEM */
+int32_t bvh_raycast(struct bvh *bvh, struct vec3 origin, struct vec3 direction, struct vec3_soa center, struct vec3_soa extent, float *distance);
+
+void bvh_destroy(struct bvh *bvh);
+
+#endif
@@ -20,6 +20,8 @@ struct input {
 	struct input_button_state look_down;
 	struct input_button_state action;
 	struct input_button_state lmb;
+	float mouse_x; /* window pixels, origin top left */
+	float mouse_y;
 };
 
 void input_button_process(struct input_button_state *button, int32_t is_down);
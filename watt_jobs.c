@@ -0,0 +1,179 @@
+#include "watt_jobs.h"
+
+#include <stdlib.h> /* malloc, realloc, free */
+#include <string.h> /* memset, memcpy */
+#include <assert.h> /* assert */
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define WATT_JOBS_THREADS 0
+#else
+#define WATT_JOBS_THREADS 1
+#include <pthread.h> /* pthread_create, pthread_mutex_*, pthread_cond_* */
+#include <unistd.h>  /* sysconf */
+#endif
+
+#if WATT_JOBS_THREADS
+static void *worker_main(void *data)
+{
+	struct jobs *jobs;
+	struct job job;
+	int32_t worker;
+
+	jobs = data;
+	pthread_mutex_lock(jobs->lock);
+	worker = jobs->started++;
+	for (;;) {
+		while (jobs->queue_count == 0 && !jobs->stop) {
+			pthread_cond_wait(jobs->job_ready, jobs->lock);
+		}
+		if (jobs->queue_count == 0) {
+			break;
+		}
+		job = jobs->queue[jobs->queue_head];
+		jobs->queue_head = (jobs->queue_head + 1) % jobs->queue_capacity;
+		--jobs->queue_count;
+		pthread_mutex_unlock(jobs->lock);
+
+		job.func(job.data, worker);
+
+		pthread_mutex_lock(jobs->lock);
+		if (--jobs->pending == 0) {
+			pthread_cond_broadcast(jobs->job_done);
+		}
+	}
+	pthread_mutex_unlock(jobs->lock);
+	return 0;
+}
+#endif
+
+int32_t jobs_create(struct jobs *jobs, int32_t thread_count)
+{
+	assert(jobs && thread_count >= 0);
+	memset(jobs, 0, sizeof(*jobs));
+	thread_count = (thread_count > JOBS_MAX_THREADS) ? JOBS_MAX_THREADS : thread_count;
+#if WATT_JOBS_THREADS
+	if (thread_count == 0) {
+		return 1;
+	}
+	jobs->threads = malloc((size_t)thread_count * sizeof(pthread_t));
+	jobs->lock = malloc(sizeof(pthread_mutex_t));
+	jobs->job_ready = malloc(sizeof(pthread_cond_t));
+	jobs->job_done = malloc(sizeof(pthread_cond_t));
+	if (!jobs->threads || !jobs->lock || !jobs->job_ready || !jobs->job_done) {
+		free(jobs->threads);
+		free(jobs->lock);
+		free(jobs->job_ready);
+		free(jobs->job_done);
+		memset(jobs, 0, sizeof(*jobs));
+		return 0;
+	}
+	pthread_mutex_init(jobs->lock, 0);
+	pthread_cond_init(jobs->job_ready, 0);
+	pthread_cond_init(jobs->job_done, 0);
+	for (; jobs->thread_count < thread_count; ++jobs->thread_count) {
+		if (pthread_create(&((pthread_t *)jobs->threads)[jobs->thread_count], 0, worker_main, jobs) != 0) {
+			break;
+		}
+	}
+#endif
+	return 1;
+}
+
+void jobs_push(struct jobs *jobs, job_func func, void *data)
+{
+#if WATT_JOBS_THREADS
+	struct job *queue;
+	int32_t capacity, tail;
+#endif
+
+	assert(jobs && func);
+	if (jobs->thread_count == 0) {
+		func(data, jobs->thread_count);
+		return;
+	}
+#if WATT_JOBS_THREADS
+	pthread_mutex_lock(jobs->lock);
+	if (jobs->queue_count == jobs->queue_capacity) {
+		/* grow and unwrap the ring so the head is at 0 again */
+		capacity = (jobs->queue_capacity > 0) ? jobs->queue_capacity * 2 : 64;
+		queue = malloc((size_t)capacity * sizeof(struct job));
+		if (!queue) {
+			pthread_mutex_unlock(jobs->lock);
+			func(data, jobs->thread_count);
+			return;
+		}
+		tail = jobs->queue_capacity - jobs->queue_head;
+		if (jobs->queue_count > 0) {
+			memcpy(queue, jobs->queue + jobs->queue_head, (size_t)tail * sizeof(struct job));
+			memcpy(queue + tail, jobs->queue, (size_t)jobs->queue_head * sizeof(struct job));
+		}
+		free(jobs->queue);
+		jobs->queue = queue;
+		jobs->queue_head = 0;
+		jobs->queue_capacity = capacity;
+	}
+	jobs->queue[(jobs->queue_head + jobs->queue_count) % jobs->queue_capacity].func = func;
+	jobs->queue[(jobs->queue_head + jobs->queue_count) % jobs->queue_capacity].data = data;
+	++jobs->queue_count;
+	++jobs->pending;
+	pthread_cond_signal(jobs->job_ready);
+	pthread_mutex_unlock(jobs->lock);
+#endif
+}
+
+void jobs_wait(struct jobs *jobs)
+{
+	assert(jobs);
+	if (jobs->thread_count == 0) {
+		return;
+	}
+#if WATT_JOBS_THREADS
+	pthread_mutex_lock(jobs->lock);
+	while (jobs->pending > 0) {
+		pthread_cond_wait(jobs->job_done, jobs->lock);
+	}
+	pthread_mutex_unlock(jobs->lock);
+#endif
+}
+
+void jobs_destroy(struct jobs *jobs)
+{
+#if WATT_JOBS_THREADS
+	int32_t i;
+#endif
+
+	assert(jobs);
+#if WATT_JOBS_THREADS
+	if (jobs->thread_count > 0) {
+		/* workers drain the queue before they see stop */
+		pthread_mutex_lock(jobs->lock);
+		jobs->stop = 1;
+		pthread_cond_broadcast(jobs->job_ready);
+		pthread_mutex_unlock(jobs->lock);
+		for (i = 0; i < jobs->thread_count; ++i) {
+			pthread_join(((pthread_t *)jobs->threads)[i], 0);
+		}
+	}
+	if (jobs->lock) {
+		pthread_mutex_destroy(jobs->lock);
+		pthread_cond_destroy(jobs->job_ready);
+		pthread_cond_destroy(jobs->job_done);
+	}
+#endif
+	free(jobs->queue);
+	free(jobs->threads);
+	free(jobs->lock);
+	free(jobs->job_ready);
+	free(jobs->job_done);
+	memset(jobs, 0, sizeof(*jobs));
+}
+
+int32_t jobs_cpu_count(void)
+{
+#if WATT_JOBS_THREADS
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (int32_t)count : 1;
+#else
+	return 1;
+#endif
+}
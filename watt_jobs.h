@@ -0,0 +1,54 @@
+#ifndef WATT_JOBS_H
+#define WATT_JOBS_H
+
+#include <stdint.h>
+
+/*
+ * fixed set of worker threads draining a fifo of jobs
+ *
+ * a zeroed struct jobs (or one created with 0 threads) is valid and runs
+ * every job on the calling thread inside jobs_push, so callers don't need
+ * a separate serial path. builds without threads (emscripten without
+ * pthreads) always run that way.
+ *
+ * jobs get the index of the worker running them, 0 to thread_count - 1, or
+ * thread_count when run inline, so they can pick per-worker scratch state
+ * from an array of JOBS_MAX_THREADS + 1 without locking.
+ */
+
+#define JOBS_MAX_THREADS 64
+
+typedef void (*job_func)(void *data, int32_t worker);
+
+struct job {
+	job_func func;
+	void *data;
+};
+
+struct jobs {
+	struct job *queue;    /* ring buffer, queue_capacity entries */
+	void *threads;        /* pthread_t[thread_count] */
+	void *lock;           /* pthread_mutex_t */
+	void *job_ready;      /* pthread_cond_t, signalled on push and stop */
+	void *job_done;       /* pthread_cond_t, signalled when pending drops to 0 */
+	int32_t queue_head;
+	int32_t queue_count;
+	int32_t queue_capacity;
+	int32_t pending;      /* queued plus running */
+	int32_t thread_count;
+	int32_t started;      /* workers that took their index */
+	int32_t stop;
+};
+
+int32_t jobs_create(struct jobs *jobs, int32_t thread_count);
+void jobs_push(struct jobs *jobs, job_func func, void *data);
+
+/* blocks until every pushed job has finished */
+void jobs_wait(struct jobs *jobs);
+
+void jobs_destroy(struct jobs *jobs);
+
+/* online cpu count, at least 1 */
+int32_t jobs_cpu_count(void);
+
+#endif
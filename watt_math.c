@@ -82,6 +82,16 @@ struct quat quat_axis_angle(struct vec3 axis, float rad)
 	return result;
 }
 
+/* the rotation of mat4_compose_euler, x then y then z in radians */
+struct quat quat_from_euler(struct vec3 rotation)
+{
+	struct quat result;
+	result = quat_axis_angle(v3(1.0f, 0.0f, 0.0f), rotation.x);
+	result = quat_multiply(result, quat_axis_angle(v3(0.0f, 1.0f, 0.0f), rotation.y));
+	result = quat_multiply(result, quat_axis_angle(v3(0.0f, 0.0f, 1.0f), rotation.z));
+	return result;
+}
+
 struct quat quat_multiply(struct quat a, struct quat b)
 {
 	struct quat result;
@@ -92,6 +102,20 @@ struct quat quat_multiply(struct quat a, struct quat b)
 	return result;
 }
 
+/* keeps repeatedly multiplied rotations from drifting off unit length */
+struct quat quat_normalize(struct quat q)
+{
+	struct quat result;
+	float inv_length;
+
+	inv_length = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+	result.x = q.x * inv_length;
+	result.y = q.y * inv_length;
+	result.z = q.z * inv_length;
+	result.w = q.w * inv_length;
+	return result;
+}
+
 struct vec3 quat_rotate(struct vec3 v, struct quat q)
 {
 	struct vec3 result, qv, tmp;
@@ -117,12 +141,24 @@ struct mat4 mat4_identity(void)
 	return result;
 }
 
-struct mat4 mat4_add(struct mat4 m0, struct mat4 m1)
+/*
+ * mat4_add, mat4_multiply, mat4_multiply_scalar and mat4_inverse run
+ * through a table of kernels. the scalar ones below are the reference the SIMD ones are
+ * tested against, math_backend_set swaps the table.
+ */
+struct math_kernels {
+	void (*mat4_add)(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1);
+	void (*mat4_multiply)(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1);
+	void (*mat4_multiply_scalar)(struct mat4 *out, const struct mat4 *m, float f);
+	void (*mat4_multiply_array)(struct mat4 *out, const struct mat4 *m, const struct mat4 *in, int32_t count);
+	void (*mat4_inverse)(struct mat4 *out, const struct mat4 *m);
+};
+
+static void mat4_add_c(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1)
 {
-	struct mat4 result;
-	float *a = &m0.x.x;
-	float *b = &m1.x.x;
-	float *c = &result.x.x;
+	const float *a = &m0->x.x;
+	const float *b = &m1->x.x;
+	float *c = &out->x.x;
 	int32_t i, j, i4, index;
 
 	for (i = 0; i < 4; ++i) {
@@ -132,14 +168,13 @@ struct mat4 mat4_add(struct mat4 m0, struct mat4 m1)
 			c[index] = a[index] + b[index];
 		}
 	}
-	return result;
 }
 
-struct mat4 mat4_multiply(struct mat4 m0, struct mat4 m1)
+static void mat4_multiply_c(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1)
 {
 	struct mat4 result;
-	float *a = &m0.x.x;
-	float *b = &m1.x.x;
+	const float *a = &m0->x.x;
+	const float *b = &m1->x.x;
 	float *c = &result.x.x;
 	int32_t i, j, i4;
 
@@ -150,14 +185,13 @@ struct mat4 mat4_multiply(struct mat4 m0, struct mat4 m1)
 						a[3 * 4 + j] * b[i4 + 3];
 		}
 	}
-	return result;
+	*out = result;
 }
 
-struct mat4 mat4_multiply_scalar(struct mat4 m, float f)
+static void mat4_multiply_scalar_c(struct mat4 *out, const struct mat4 *m, float f)
 {
-	struct mat4 result;
-	float *a = &m.x.x;
-	float *b = &result.x.x;
+	const float *a = &m->x.x;
+	float *b = &out->x.x;
 	int32_t i, j, i4, index;
 
 	for (i = 0; i < 4; ++i) {
@@ -167,9 +201,114 @@ struct mat4 mat4_multiply_scalar(struct mat4 m, float f)
 			b[index] = a[index] * f;
 		}
 	}
+}
+
+static void mat4_multiply_array_c(struct mat4 *out, const struct mat4 *m, const struct mat4 *in, int32_t count)
+{
+	int32_t i;
+
+	for (i = 0; i < count; ++i) {
+		mat4_multiply_c(&out[i], m, &in[i]);
+	}
+}
+
+/*
+ * cofactor expansion through the 2x2 determinants of the first two and the
+ * last two columns. the inverse of the transpose is the transpose of the
+ * inverse, so the same formula works on the column ordered elements as if
+ * they were rows.
+ */
+static void mat4_inverse_c(struct mat4 *out, const struct mat4 *m)
+{
+	const float *a = &m->x.x;
+	float s0, s1, s2, s3, s4, s5, c0, c1, c2, c3, c4, c5, inv_det;
+	struct mat4 result;
+	float *b = &result.x.x;
+
+	s0 = a[0] * a[5] - a[4] * a[1];
+	s1 = a[0] * a[6] - a[4] * a[2];
+	s2 = a[0] * a[7] - a[4] * a[3];
+	s3 = a[1] * a[6] - a[5] * a[2];
+	s4 = a[1] * a[7] - a[5] * a[3];
+	s5 = a[2] * a[7] - a[6] * a[3];
+	c5 = a[10] * a[15] - a[14] * a[11];
+	c4 = a[9] * a[15] - a[13] * a[11];
+	c3 = a[9] * a[14] - a[13] * a[10];
+	c2 = a[8] * a[15] - a[12] * a[11];
+	c1 = a[8] * a[14] - a[12] * a[10];
+	c0 = a[8] * a[13] - a[12] * a[9];
+	inv_det = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+	b[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * inv_det;
+	b[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * inv_det;
+	b[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * inv_det;
+	b[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * inv_det;
+	b[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * inv_det;
+	b[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * inv_det;
+	b[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * inv_det;
+	b[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * inv_det;
+	b[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * inv_det;
+	b[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * inv_det;
+	b[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * inv_det;
+	b[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * inv_det;
+	b[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * inv_det;
+	b[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * inv_det;
+	b[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * inv_det;
+	b[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * inv_det;
+	*out = result;
+}
+
+static struct math_kernels math_kernels = {mat4_add_c, mat4_multiply_c, mat4_multiply_scalar_c, mat4_multiply_array_c, mat4_inverse_c};
+static int32_t math_kernels_backend = MATH_BACKEND_SCALAR;
+
+struct mat4 mat4_add(struct mat4 m0, struct mat4 m1)
+{
+	struct mat4 result;
+	math_kernels.mat4_add(&result, &m0, &m1);
 	return result;
 }
 
+struct mat4 mat4_multiply(struct mat4 m0, struct mat4 m1)
+{
+	struct mat4 result;
+	math_kernels.mat4_multiply(&result, &m0, &m1);
+	return result;
+}
+
+struct mat4 mat4_multiply_scalar(struct mat4 m, float f)
+{
+	struct mat4 result;
+	math_kernels.mat4_multiply_scalar(&result, &m, f);
+	return result;
+}
+
+void mat4_add_into(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1)
+{
+	math_kernels.mat4_add(out, m0, m1);
+}
+
+void mat4_multiply_into(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1)
+{
+	math_kernels.mat4_multiply(out, m0, m1);
+}
+
+void mat4_multiply_scalar_into(struct mat4 *out, const struct mat4 *m, float f)
+{
+	math_kernels.mat4_multiply_scalar(out, m, f);
+}
+
+struct mat4 mat4_inverse(struct mat4 m)
+{
+	struct mat4 result;
+	math_kernels.mat4_inverse(&result, &m);
+	return result;
+}
+
+void mat4_inverse_into(struct mat4 *out, const struct mat4 *m)
+{
+	math_kernels.mat4_inverse(out, m);
+}
+
 struct mat4 mat4_scale(struct mat4 m, struct vec3 v)
 {
 	struct mat4 result;
@@ -283,3 +422,1328 @@ struct mat4 mat4_perspective(float fov, float aspect, float z_near, float z_far)
 	result.w.z = (-2.0f * z_near * z_far) / z_range;
 	return result;
 }
+
+/*
+ * translate * rotate_x * rotate_y * rotate_z * scale, the same transform as
+ * chaining mat4_translate, mat4_rotate_x/y/z and mat4_scale, written out
+ * directly. rotation is in radians.
+ */
+struct mat4 mat4_compose_euler(struct vec3 position, struct vec3 rotation, struct vec3 scale)
+{
+	float ca, sa, cb, sb, cc, sc;
+	struct mat4 result;
+
+	ca = cosf(rotation.x);
+	sa = sinf(rotation.x);
+	cb = cosf(rotation.y);
+	sb = sinf(rotation.y);
+	cc = cosf(rotation.z);
+	sc = sinf(rotation.z);
+
+	result.x.x = cb * cc * scale.x;
+	result.x.y = (ca * sc + sa * sb * cc) * scale.x;
+	result.x.z = (sa * sc - ca * sb * cc) * scale.x;
+	result.x.w = 0.0f;
+	result.y.x = -cb * sc * scale.y;
+	result.y.y = (ca * cc - sa * sb * sc) * scale.y;
+	result.y.z = (sa * cc + ca * sb * sc) * scale.y;
+	result.y.w = 0.0f;
+	result.z.x = sb * scale.z;
+	result.z.y = -sa * cb * scale.z;
+	result.z.z = ca * cb * scale.z;
+	result.z.w = 0.0f;
+	result.w.x = position.x;
+	result.w.y = position.y;
+	result.w.z = position.z;
+	result.w.w = 1.0f;
+	return result;
+}
+
+/*
+ * translate * rotate(quat) * scale written straight into the affine columns,
+ * about 30 flops and no trig. rotation is expected to be unit length.
+ */
+struct mat4 mat4_from_trs(struct vec3 position, struct quat rotation, struct vec3 scale)
+{
+	float x2, y2, z2, xx, yy, zz, xy, xz, yz, wx, wy, wz;
+	struct mat4 result;
+
+	x2 = rotation.x + rotation.x;
+	y2 = rotation.y + rotation.y;
+	z2 = rotation.z + rotation.z;
+	xx = rotation.x * x2;
+	yy = rotation.y * y2;
+	zz = rotation.z * z2;
+	xy = rotation.x * y2;
+	xz = rotation.x * z2;
+	yz = rotation.y * z2;
+	wx = rotation.w * x2;
+	wy = rotation.w * y2;
+	wz = rotation.w * z2;
+
+	result.x.x = (1.0f - (yy + zz)) * scale.x;
+	result.x.y = (xy + wz) * scale.x;
+	result.x.z = (xz - wy) * scale.x;
+	result.x.w = 0.0f;
+	result.y.x = (xy - wz) * scale.y;
+	result.y.y = (1.0f - (xx + zz)) * scale.y;
+	result.y.z = (yz + wx) * scale.y;
+	result.y.w = 0.0f;
+	result.z.x = (xz + wy) * scale.z;
+	result.z.y = (yz - wx) * scale.z;
+	result.z.z = (1.0f - (xx + yy)) * scale.z;
+	result.z.w = 0.0f;
+	result.w.x = position.x;
+	result.w.y = position.y;
+	result.w.z = position.z;
+	result.w.w = 1.0f;
+	return result;
+}
+
+struct affine3x4 affine_identity(void)
+{
+	struct affine3x4 result;
+	result.x = v4(1.0f, 0.0f, 0.0f, 0.0f);
+	result.y = v4(0.0f, 1.0f, 0.0f, 0.0f);
+	result.z = v4(0.0f, 0.0f, 1.0f, 0.0f);
+	return result;
+}
+
+struct affine3x4 affine_from_mat4(struct mat4 m)
+{
+	struct affine3x4 result;
+	result.x = v4(m.x.x, m.y.x, m.z.x, m.w.x);
+	result.y = v4(m.x.y, m.y.y, m.z.y, m.w.y);
+	result.z = v4(m.x.z, m.y.z, m.z.z, m.w.z);
+	return result;
+}
+
+struct mat4 affine_to_mat4(struct affine3x4 a)
+{
+	struct mat4 result;
+	result.x = v4(a.x.x, a.y.x, a.z.x, 0.0f);
+	result.y = v4(a.x.y, a.y.y, a.z.y, 0.0f);
+	result.z = v4(a.x.z, a.y.z, a.z.z, 0.0f);
+	result.w = v4(a.x.w, a.y.w, a.z.w, 1.0f);
+	return result;
+}
+
+/* mat4_from_trs without the bottom row */
+struct affine3x4 affine_from_trs(struct vec3 position, struct quat rotation, struct vec3 scale)
+{
+	float x2, y2, z2, xx, yy, zz, xy, xz, yz, wx, wy, wz;
+	struct affine3x4 result;
+
+	x2 = rotation.x + rotation.x;
+	y2 = rotation.y + rotation.y;
+	z2 = rotation.z + rotation.z;
+	xx = rotation.x * x2;
+	yy = rotation.y * y2;
+	zz = rotation.z * z2;
+	xy = rotation.x * y2;
+	xz = rotation.x * z2;
+	yz = rotation.y * z2;
+	wx = rotation.w * x2;
+	wy = rotation.w * y2;
+	wz = rotation.w * z2;
+
+	result.x = v4((1.0f - (yy + zz)) * scale.x, (xy - wz) * scale.y, (xz + wy) * scale.z, position.x);
+	result.y = v4((xy + wz) * scale.x, (1.0f - (xx + zz)) * scale.y, (yz - wx) * scale.z, position.y);
+	result.z = v4((xz - wy) * scale.x, (yz + wx) * scale.y, (1.0f - (xx + yy)) * scale.z, position.z);
+	return result;
+}
+
+/* one row of a * b, the rows of b weighted by the row of a plus its translation */
+static struct vec4 affine_multiply_row(struct vec4 r, const struct affine3x4 *b)
+{
+	struct vec4 result;
+	result.x = r.x * b->x.x + r.y * b->y.x + r.z * b->z.x;
+	result.y = r.x * b->x.y + r.y * b->y.y + r.z * b->z.y;
+	result.z = r.x * b->x.z + r.y * b->y.z + r.z * b->z.z;
+	result.w = r.x * b->x.w + r.y * b->y.w + r.z * b->z.w + r.w;
+	return result;
+}
+
+/* a * b as if both were mat4, 36 multiplies instead of 64 */
+struct affine3x4 affine_multiply(struct affine3x4 a, struct affine3x4 b)
+{
+	struct affine3x4 result;
+	result.x = affine_multiply_row(a.x, &b);
+	result.y = affine_multiply_row(a.y, &b);
+	result.z = affine_multiply_row(a.z, &b);
+	return result;
+}
+
+/*
+ * inverse of the 3x3 part from the cross products of its rows (the
+ * transposed cofactors over the determinant), then the translation is
+ * taken back through it. a has to be invertible.
+ */
+struct affine3x4 affine_inverse(struct affine3x4 a)
+{
+	struct vec3 r0, r1, r2, c0, c1, c2, t;
+	struct affine3x4 result;
+	float inv_det;
+
+	r0 = v3(a.x.x, a.x.y, a.x.z);
+	r1 = v3(a.y.x, a.y.y, a.y.z);
+	r2 = v3(a.z.x, a.z.y, a.z.z);
+	c0 = vec3_cross(r1, r2);
+	c1 = vec3_cross(r2, r0);
+	c2 = vec3_cross(r0, r1);
+	inv_det = 1.0f / vec3_dot(r0, c0);
+	c0 = vec3_scale(c0, inv_det);
+	c1 = vec3_scale(c1, inv_det);
+	c2 = vec3_scale(c2, inv_det);
+
+	/* c0, c1, c2 are the columns of the inverse */
+	t = v3(a.x.w, a.y.w, a.z.w);
+	result.x = v4(c0.x, c1.x, c2.x, -(c0.x * t.x + c1.x * t.y + c2.x * t.z));
+	result.y = v4(c0.y, c1.y, c2.y, -(c0.y * t.x + c1.y * t.y + c2.y * t.z));
+	result.z = v4(c0.z, c1.z, c2.z, -(c0.z * t.x + c1.z * t.y + c2.z * t.z));
+	return result;
+}
+
+/* the inverse of a rotation is its transpose, no determinant or division needed */
+struct affine3x4 affine_inverse_rigid(struct affine3x4 a)
+{
+	struct affine3x4 result;
+	result.x = v4(a.x.x, a.y.x, a.z.x, -(a.x.x * a.x.w + a.y.x * a.y.w + a.z.x * a.z.w));
+	result.y = v4(a.x.y, a.y.y, a.z.y, -(a.x.y * a.x.w + a.y.y * a.y.w + a.z.y * a.z.w));
+	result.z = v4(a.x.z, a.y.z, a.z.z, -(a.x.z * a.x.w + a.y.z * a.y.w + a.z.z * a.z.w));
+	return result;
+}
+
+struct vec3 affine_transform_point(struct affine3x4 a, struct vec3 p)
+{
+	struct vec3 result;
+	result.x = a.x.x * p.x + a.x.y * p.y + a.x.z * p.z + a.x.w;
+	result.y = a.y.x * p.x + a.y.y * p.y + a.y.z * p.z + a.y.w;
+	result.z = a.z.x * p.x + a.z.y * p.y + a.z.z * p.z + a.z.w;
+	return result;
+}
+
+/*
+ * n by the inverse transpose of the 3x3 part, so normals stay perpendicular
+ * under non-uniform scale. the cofactor matrix only differs from it by the
+ * determinant, whose sign is kept for mirroring transforms. returns a unit
+ * vector.
+ */
+struct vec3 affine_transform_normal(struct affine3x4 a, struct vec3 n)
+{
+	struct vec3 r0, r1, r2, c0, c1, c2, result;
+
+	r0 = v3(a.x.x, a.x.y, a.x.z);
+	r1 = v3(a.y.x, a.y.y, a.y.z);
+	r2 = v3(a.z.x, a.z.y, a.z.z);
+	c0 = vec3_cross(r1, r2);
+	c1 = vec3_cross(r2, r0);
+	c2 = vec3_cross(r0, r1);
+	result = v3(vec3_dot(c0, n), vec3_dot(c1, n), vec3_dot(c2, n));
+	if (vec3_dot(r0, c0) < 0.0f) {
+		result = vec3_scale(result, -1.0f);
+	}
+	return vec3_normalize(result);
+}
+
+struct aabb aabb_union(struct aabb a, struct aabb b)
+{
+	struct aabb result;
+	result.min = v3(fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z));
+	result.max = v3(fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z));
+	return result;
+}
+
+/* bounds of the transformed box, m is assumed to be affine */
+struct aabb aabb_transform(struct aabb a, struct mat4 m)
+{
+	struct vec3 center, extent, world_center, world_extent;
+	struct aabb result;
+
+	center = vec3_scale(vec3_add(a.min, a.max), 0.5f);
+	extent = vec3_scale(vec3_add(a.max, vec3_scale(a.min, -1.0f)), 0.5f);
+
+	world_center.x = m.x.x * center.x + m.y.x * center.y + m.z.x * center.z + m.w.x;
+	world_center.y = m.x.y * center.x + m.y.y * center.y + m.z.y * center.z + m.w.y;
+	world_center.z = m.x.z * center.x + m.y.z * center.y + m.z.z * center.z + m.w.z;
+	world_extent.x = fabsf(m.x.x) * extent.x + fabsf(m.y.x) * extent.y + fabsf(m.z.x) * extent.z;
+	world_extent.y = fabsf(m.x.y) * extent.x + fabsf(m.y.y) * extent.y + fabsf(m.z.y) * extent.z;
+	world_extent.z = fabsf(m.x.z) * extent.x + fabsf(m.y.z) * extent.y + fabsf(m.z.z) * extent.z;
+
+	result.min = vec3_add(world_center, vec3_scale(world_extent, -1.0f));
+	result.max = vec3_add(world_center, world_extent);
+	return result;
+}
+
+struct aabb aabb_transform_affine(struct aabb a, struct affine3x4 m)
+{
+	struct vec3 center, extent, world_center, world_extent;
+	struct aabb result;
+
+	center = vec3_scale(vec3_add(a.min, a.max), 0.5f);
+	extent = vec3_scale(vec3_add(a.max, vec3_scale(a.min, -1.0f)), 0.5f);
+
+	world_center = affine_transform_point(m, center);
+	world_extent.x = fabsf(m.x.x) * extent.x + fabsf(m.x.y) * extent.y + fabsf(m.x.z) * extent.z;
+	world_extent.y = fabsf(m.y.x) * extent.x + fabsf(m.y.y) * extent.y + fabsf(m.y.z) * extent.z;
+	world_extent.z = fabsf(m.z.x) * extent.x + fabsf(m.z.y) * extent.y + fabsf(m.z.z) * extent.z;
+
+	result.min = vec3_add(world_center, vec3_scale(world_extent, -1.0f));
+	result.max = vec3_add(world_center, world_extent);
+	return result;
+}
+
+/* gribb/hartmann plane extraction, for gl style clip space (-w <= z <= w) */
+struct frustum frustum_from_mat4(struct mat4 view_proj)
+{
+	struct frustum result;
+	struct vec4 rows[4];
+	float length;
+	int32_t i, axis, sign;
+
+	rows[0] = v4(view_proj.x.x, view_proj.y.x, view_proj.z.x, view_proj.w.x);
+	rows[1] = v4(view_proj.x.y, view_proj.y.y, view_proj.z.y, view_proj.w.y);
+	rows[2] = v4(view_proj.x.z, view_proj.y.z, view_proj.z.z, view_proj.w.z);
+	rows[3] = v4(view_proj.x.w, view_proj.y.w, view_proj.z.w, view_proj.w.w);
+
+	for (i = 0; i < 6; ++i) {
+		axis = i / 2;
+		sign = (i % 2 == 0) ? 1 : -1;
+		result.planes[i].x = rows[3].x + (float)sign * rows[axis].x;
+		result.planes[i].y = rows[3].y + (float)sign * rows[axis].y;
+		result.planes[i].z = rows[3].z + (float)sign * rows[axis].z;
+		result.planes[i].w = rows[3].w + (float)sign * rows[axis].w;
+
+		length = vec3_length(v3(result.planes[i].x, result.planes[i].y, result.planes[i].z));
+		result.planes[i].x /= length;
+		result.planes[i].y /= length;
+		result.planes[i].z /= length;
+		result.planes[i].w /= length;
+	}
+	return result;
+}
+
+/* conservative box test, 0 only when the box is fully outside one plane */
+int32_t frustum_test_aabb(struct frustum f, struct vec3 center, struct vec3 extent)
+{
+	struct vec4 p;
+	int32_t i;
+
+	for (i = 0; i < 6; ++i) {
+		p = f.planes[i];
+		if (p.x * center.x + p.y * center.y + p.z * center.z + p.w + fabsf(p.x) * extent.x + fabsf(p.y) * extent.y + fabsf(p.z) * extent.z < 0.0f) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* like frustum_test_aabb but also tells boxes fully inside all planes apart */
+int32_t frustum_classify_aabb(struct frustum f, struct vec3 center, struct vec3 extent)
+{
+	struct vec4 p;
+	float distance, radius;
+	int32_t i, result;
+
+	result = FRUSTUM_INSIDE;
+	for (i = 0; i < 6; ++i) {
+		p = f.planes[i];
+		distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+		radius = fabsf(p.x) * extent.x + fabsf(p.y) * extent.y + fabsf(p.z) * extent.z;
+		if (distance + radius < 0.0f) {
+			return FRUSTUM_OUTSIDE;
+		}
+		if (distance - radius < 0.0f) {
+			result = FRUSTUM_INTERSECTS;
+		}
+	}
+	return result;
+}
+
+/*
+ * slab test, returns 1 and the entry distance along direction (0 when origin
+ * is inside) if the ray hits the box before max_distance
+ */
+int32_t ray_intersect_aabb(struct vec3 origin, struct vec3 direction, struct aabb box, float max_distance, float *distance)
+{
+	float o[3], d[3], lo[3], hi[3];
+	float t_enter, t_exit, t0, t1, inv, tmp;
+	int32_t i;
+
+	o[0] = origin.x, o[1] = origin.y, o[2] = origin.z;
+	d[0] = direction.x, d[1] = direction.y, d[2] = direction.z;
+	lo[0] = box.min.x, lo[1] = box.min.y, lo[2] = box.min.z;
+	hi[0] = box.max.x, hi[1] = box.max.y, hi[2] = box.max.z;
+
+	t_enter = 0.0f;
+	t_exit = max_distance;
+	for (i = 0; i < 3; ++i) {
+		if (d[i] == 0.0f) {
+			if (o[i] < lo[i] || o[i] > hi[i]) {
+				return 0;
+			}
+			continue;
+		}
+		inv = 1.0f / d[i];
+		t0 = (lo[i] - o[i]) * inv;
+		t1 = (hi[i] - o[i]) * inv;
+		if (t0 > t1) {
+			tmp = t0, t0 = t1, t1 = tmp;
+		}
+		t_enter = fmaxf(t_enter, t0);
+		t_exit = fminf(t_exit, t1);
+		if (t_enter > t_exit) {
+			return 0;
+		}
+	}
+	*distance = t_enter;
+	return 1;
+}
+
+struct vec3 unproject(struct vec2 ndc, float depth, struct mat4 inv_view_proj)
+{
+	const struct mat4 *m = &inv_view_proj;
+	float x, y, z, inv_w;
+
+	x = m->x.x * ndc.x + m->y.x * ndc.y + m->z.x * depth + m->w.x;
+	y = m->x.y * ndc.x + m->y.y * ndc.y + m->z.y * depth + m->w.y;
+	z = m->x.z * ndc.x + m->y.z * ndc.y + m->z.z * depth + m->w.z;
+	inv_w = 1.0f / (m->x.w * ndc.x + m->y.w * ndc.y + m->z.w * depth + m->w.w);
+	return v3(x * inv_w, y * inv_w, z * inv_w);
+}
+
+struct ray unproject_ray(struct vec2 ndc, struct mat4 inv_view_proj)
+{
+	struct vec3 near_point, far_point;
+	struct ray result;
+
+	near_point = unproject(ndc, -1.0f, inv_view_proj);
+	far_point = unproject(ndc, 1.0f, inv_view_proj);
+	result.origin = near_point;
+	result.direction = vec3_normalize(vec3_add(far_point, vec3_scale(near_point, -1.0f)));
+	return result;
+}
+
+/*
+ * vector sincos: reduce to [-pi/4, pi/4] around the nearest multiple of
+ * pi/2 (three part cody-waite), evaluate the cephes sinf/cosf polynomials,
+ * then swap and negate by quadrant. max error is a few ulp for |x| < 8192.
+ */
+
+#define WATT_SINCOS_2_OVER_PI 0.636619772367581f
+#define WATT_SINCOS_DP1 1.5703125f
+#define WATT_SINCOS_DP2 4.837512969970703125e-4f
+#define WATT_SINCOS_DP3 7.54978995489188216e-8f
+#define WATT_SINCOS_S1 -1.6666654611e-1f
+#define WATT_SINCOS_S2 8.3321608736e-3f
+#define WATT_SINCOS_S3 -1.9515295891e-4f
+#define WATT_SINCOS_C1 4.166664568298827e-2f
+#define WATT_SINCOS_C2 -1.388731625493765e-3f
+#define WATT_SINCOS_C3 2.443315711809948e-5f
+
+#if defined(__SSE2__)
+#include <emmintrin.h> /* SSE2 */
+
+static void sincos_sse2(__m128 x, __m128 *s, __m128 *c)
+{
+	__m128i quadrant, one, two;
+	__m128 j, r, r2, sin_r, cos_r, swap, sin_sign, cos_sign, sign_bit;
+
+	quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(WATT_SINCOS_2_OVER_PI)));
+	j = _mm_cvtepi32_ps(quadrant);
+	r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(WATT_SINCOS_DP1)));
+	r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(WATT_SINCOS_DP2)));
+	r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(WATT_SINCOS_DP3)));
+	r2 = _mm_mul_ps(r, r);
+
+	sin_r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(WATT_SINCOS_S3), r2), _mm_set1_ps(WATT_SINCOS_S2));
+	sin_r = _mm_add_ps(_mm_mul_ps(sin_r, r2), _mm_set1_ps(WATT_SINCOS_S1));
+	sin_r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sin_r, r2), r), r);
+
+	cos_r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(WATT_SINCOS_C3), r2), _mm_set1_ps(WATT_SINCOS_C2));
+	cos_r = _mm_add_ps(_mm_mul_ps(cos_r, r2), _mm_set1_ps(WATT_SINCOS_C1));
+	cos_r = _mm_mul_ps(_mm_mul_ps(cos_r, r2), r2);
+	cos_r = _mm_add_ps(_mm_sub_ps(cos_r, _mm_mul_ps(r2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+	one = _mm_set1_epi32(1);
+	two = _mm_set1_epi32(2);
+	swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+	sin_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+	cos_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+	sign_bit = _mm_set1_ps(-0.0f);
+
+	*s = _mm_or_ps(_mm_and_ps(swap, cos_r), _mm_andnot_ps(swap, sin_r));
+	*c = _mm_or_ps(_mm_and_ps(swap, sin_r), _mm_andnot_ps(swap, cos_r));
+	*s = _mm_xor_ps(*s, _mm_and_ps(sin_sign, sign_bit));
+	*c = _mm_xor_ps(*c, _mm_and_ps(cos_sign, sign_bit));
+}
+
+/* writes 4 matrices from 4 lanes of each of the 16 elements, given column by column */
+static void store_mat4_x4_sse2(struct mat4 *out, const __m128 *columns)
+{
+	__m128 a, b, c, d;
+	int32_t i;
+
+	for (i = 0; i < 4; ++i) {
+		a = columns[i * 4 + 0];
+		b = columns[i * 4 + 1];
+		c = columns[i * 4 + 2];
+		d = columns[i * 4 + 3];
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(&out[0].x.x + i * 4, a);
+		_mm_storeu_ps(&out[1].x.x + i * 4, b);
+		_mm_storeu_ps(&out[2].x.x + i * 4, c);
+		_mm_storeu_ps(&out[3].x.x + i * 4, d);
+	}
+}
+
+static void mat4_compose_euler_x4_sse2(struct mat4 *out, struct vec3_soa position, struct vec3_soa rotation, struct vec3_soa scale, int32_t i)
+{
+	__m128 ca, sa, cb, sb, cc, sc, sx, sy, sz, zero;
+	__m128 columns[16];
+
+	sincos_sse2(_mm_loadu_ps(rotation.x + i), &sa, &ca);
+	sincos_sse2(_mm_loadu_ps(rotation.y + i), &sb, &cb);
+	sincos_sse2(_mm_loadu_ps(rotation.z + i), &sc, &cc);
+	sx = _mm_loadu_ps(scale.x + i);
+	sy = _mm_loadu_ps(scale.y + i);
+	sz = _mm_loadu_ps(scale.z + i);
+	zero = _mm_setzero_ps();
+
+	columns[0] = _mm_mul_ps(_mm_mul_ps(cb, cc), sx);
+	columns[1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ca, sc), _mm_mul_ps(_mm_mul_ps(sa, sb), cc)), sx);
+	columns[2] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sa, sc), _mm_mul_ps(_mm_mul_ps(ca, sb), cc)), sx);
+	columns[3] = zero;
+	columns[4] = _mm_sub_ps(zero, _mm_mul_ps(_mm_mul_ps(cb, sc), sy));
+	columns[5] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ca, cc), _mm_mul_ps(_mm_mul_ps(sa, sb), sc)), sy);
+	columns[6] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sa, cc), _mm_mul_ps(_mm_mul_ps(ca, sb), sc)), sy);
+	columns[7] = zero;
+	columns[8] = _mm_mul_ps(sb, sz);
+	columns[9] = _mm_sub_ps(zero, _mm_mul_ps(_mm_mul_ps(sa, cb), sz));
+	columns[10] = _mm_mul_ps(_mm_mul_ps(ca, cb), sz);
+	columns[11] = zero;
+	columns[12] = _mm_loadu_ps(position.x + i);
+	columns[13] = _mm_loadu_ps(position.y + i);
+	columns[14] = _mm_loadu_ps(position.z + i);
+	columns[15] = _mm_set1_ps(1.0f);
+
+	store_mat4_x4_sse2(out + i, columns);
+}
+
+static int32_t frustum_cull_x4_sse2(uint8_t *visible, const struct frustum *f, struct vec3_soa center, struct vec3_soa extent, int32_t i)
+{
+	__m128 cx, cy, cz, ex, ey, ez, distance, radius, inside, abs_mask;
+	int32_t p, mask;
+
+	cx = _mm_loadu_ps(center.x + i);
+	cy = _mm_loadu_ps(center.y + i);
+	cz = _mm_loadu_ps(center.z + i);
+	ex = _mm_loadu_ps(extent.x + i);
+	ey = _mm_loadu_ps(extent.y + i);
+	ez = _mm_loadu_ps(extent.z + i);
+	abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	for (p = 0; p < 6; ++p) {
+		struct vec4 plane = f->planes[p];
+		distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))), _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+		radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_and_ps(_mm_set1_ps(plane.x), abs_mask)), _mm_mul_ps(ey, _mm_and_ps(_mm_set1_ps(plane.y), abs_mask))), _mm_mul_ps(ez, _mm_and_ps(_mm_set1_ps(plane.z), abs_mask)));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+	}
+
+	mask = _mm_movemask_ps(inside);
+	for (p = 0; p < 4; ++p) {
+		visible[i + p] = (uint8_t)((mask >> p) & 1);
+	}
+	return __builtin_popcount((unsigned int)mask);
+}
+
+static void quat_rotate_x4_sse2(struct vec3_soa out, struct vec3_soa v, const struct quat *q, int32_t i)
+{
+	__m128 vx, vy, vz, qx, qy, qz, qw, tx, ty, tz, two;
+
+	vx = _mm_loadu_ps(v.x + i);
+	vy = _mm_loadu_ps(v.y + i);
+	vz = _mm_loadu_ps(v.z + i);
+	qx = _mm_set1_ps(q->x);
+	qy = _mm_set1_ps(q->y);
+	qz = _mm_set1_ps(q->z);
+	qw = _mm_set1_ps(q->w);
+	two = _mm_set1_ps(2.0f);
+
+	tx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy)), _mm_mul_ps(qw, vx));
+	ty = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz)), _mm_mul_ps(qw, vy));
+	tz = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx)), _mm_mul_ps(qw, vz));
+	_mm_storeu_ps(out.x + i, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qy, tz), _mm_mul_ps(qz, ty)), two), vx));
+	_mm_storeu_ps(out.y + i, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qz, tx), _mm_mul_ps(qx, tz)), two), vy));
+	_mm_storeu_ps(out.z + i, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qx, ty), _mm_mul_ps(qy, tx)), two), vz));
+}
+
+static void vec3_transform_x4_sse2(struct vec3_soa out, const struct mat4 *m, struct vec3_soa p, int32_t i)
+{
+	__m128 px, py, pz;
+
+	px = _mm_loadu_ps(p.x + i);
+	py = _mm_loadu_ps(p.y + i);
+	pz = _mm_loadu_ps(p.z + i);
+	_mm_storeu_ps(out.x + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m->x.x), px), _mm_mul_ps(_mm_set1_ps(m->y.x), py)), _mm_mul_ps(_mm_set1_ps(m->z.x), pz)), _mm_set1_ps(m->w.x)));
+	_mm_storeu_ps(out.y + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m->x.y), px), _mm_mul_ps(_mm_set1_ps(m->y.y), py)), _mm_mul_ps(_mm_set1_ps(m->z.y), pz)), _mm_set1_ps(m->w.y)));
+	_mm_storeu_ps(out.z + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m->x.z), px), _mm_mul_ps(_mm_set1_ps(m->y.z), py)), _mm_mul_ps(_mm_set1_ps(m->z.z), pz)), _mm_set1_ps(m->w.z)));
+}
+
+/* writes 4 affine matrices from the same column ordered lanes, skipping the bottom row */
+static void store_affine_x4_sse2(struct affine3x4 *out, const __m128 *columns)
+{
+	__m128 a, b, c, d;
+	int32_t i;
+
+	for (i = 0; i < 3; ++i) {
+		a = columns[i];
+		b = columns[4 + i];
+		c = columns[8 + i];
+		d = columns[12 + i];
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(&out[0].x.x + i * 4, a);
+		_mm_storeu_ps(&out[1].x.x + i * 4, b);
+		_mm_storeu_ps(&out[2].x.x + i * 4, c);
+		_mm_storeu_ps(&out[3].x.x + i * 4, d);
+	}
+}
+
+/* the 16 matrix elements of 4 translate * rotate * scale compositions, column by column */
+static void trs_columns_x4_sse2(__m128 *columns, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t i)
+{
+	__m128 qx, qy, qz, qw, x2, y2, z2, xx, yy, zz, xy, xz, yz, wx, wy, wz, sx, sy, sz, one, zero;
+
+	qx = _mm_loadu_ps(rotation.x + i);
+	qy = _mm_loadu_ps(rotation.y + i);
+	qz = _mm_loadu_ps(rotation.z + i);
+	qw = _mm_loadu_ps(rotation.w + i);
+	x2 = _mm_add_ps(qx, qx);
+	y2 = _mm_add_ps(qy, qy);
+	z2 = _mm_add_ps(qz, qz);
+	xx = _mm_mul_ps(qx, x2);
+	yy = _mm_mul_ps(qy, y2);
+	zz = _mm_mul_ps(qz, z2);
+	xy = _mm_mul_ps(qx, y2);
+	xz = _mm_mul_ps(qx, z2);
+	yz = _mm_mul_ps(qy, z2);
+	wx = _mm_mul_ps(qw, x2);
+	wy = _mm_mul_ps(qw, y2);
+	wz = _mm_mul_ps(qw, z2);
+	sx = _mm_loadu_ps(scale.x + i);
+	sy = _mm_loadu_ps(scale.y + i);
+	sz = _mm_loadu_ps(scale.z + i);
+	one = _mm_set1_ps(1.0f);
+	zero = _mm_setzero_ps();
+
+	columns[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+	columns[1] = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+	columns[2] = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+	columns[3] = zero;
+	columns[4] = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+	columns[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+	columns[6] = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+	columns[7] = zero;
+	columns[8] = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+	columns[9] = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+	columns[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+	columns[11] = zero;
+	columns[12] = _mm_loadu_ps(position.x + i);
+	columns[13] = _mm_loadu_ps(position.y + i);
+	columns[14] = _mm_loadu_ps(position.z + i);
+	columns[15] = one;
+}
+
+static void mat4_compose_trs_x4_sse2(struct mat4 *out, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t i)
+{
+	__m128 columns[16];
+
+	trs_columns_x4_sse2(columns, position, rotation, scale, i);
+	store_mat4_x4_sse2(out + i, columns);
+}
+
+static void affine_compose_trs_x4_sse2(struct affine3x4 *out, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t i)
+{
+	__m128 columns[16];
+
+	trs_columns_x4_sse2(columns, position, rotation, scale, i);
+	store_affine_x4_sse2(out + i, columns);
+}
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h> /* AVX2 */
+
+static void sincos_avx2(__m256 x, __m256 *s, __m256 *c)
+{
+	__m256i quadrant, one, two;
+	__m256 j, r, r2, sin_r, cos_r, swap, sin_sign, cos_sign, sign_bit;
+
+	quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(WATT_SINCOS_2_OVER_PI)));
+	j = _mm256_cvtepi32_ps(quadrant);
+	r = _mm256_sub_ps(x, _mm256_mul_ps(j, _mm256_set1_ps(WATT_SINCOS_DP1)));
+	r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(WATT_SINCOS_DP2)));
+	r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(WATT_SINCOS_DP3)));
+	r2 = _mm256_mul_ps(r, r);
+
+	sin_r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(WATT_SINCOS_S3), r2), _mm256_set1_ps(WATT_SINCOS_S2));
+	sin_r = _mm256_add_ps(_mm256_mul_ps(sin_r, r2), _mm256_set1_ps(WATT_SINCOS_S1));
+	sin_r = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sin_r, r2), r), r);
+
+	cos_r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(WATT_SINCOS_C3), r2), _mm256_set1_ps(WATT_SINCOS_C2));
+	cos_r = _mm256_add_ps(_mm256_mul_ps(cos_r, r2), _mm256_set1_ps(WATT_SINCOS_C1));
+	cos_r = _mm256_mul_ps(_mm256_mul_ps(cos_r, r2), r2);
+	cos_r = _mm256_add_ps(_mm256_sub_ps(cos_r, _mm256_mul_ps(r2, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.0f));
+
+	one = _mm256_set1_epi32(1);
+	two = _mm256_set1_epi32(2);
+	swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+	sin_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+	cos_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+	sign_bit = _mm256_set1_ps(-0.0f);
+
+	*s = _mm256_blendv_ps(sin_r, cos_r, swap);
+	*c = _mm256_blendv_ps(cos_r, sin_r, swap);
+	*s = _mm256_xor_ps(*s, _mm256_and_ps(sin_sign, sign_bit));
+	*c = _mm256_xor_ps(*c, _mm256_and_ps(cos_sign, sign_bit));
+}
+
+static void mat4_compose_euler_x8_avx2(struct mat4 *out, struct vec3_soa position, struct vec3_soa rotation, struct vec3_soa scale, int32_t i)
+{
+	__m256 ca, sa, cb, sb, cc, sc, sx, sy, sz, zero;
+	__m256 columns[16];
+	__m128 lo[16], hi[16];
+	int32_t k;
+
+	sincos_avx2(_mm256_loadu_ps(rotation.x + i), &sa, &ca);
+	sincos_avx2(_mm256_loadu_ps(rotation.y + i), &sb, &cb);
+	sincos_avx2(_mm256_loadu_ps(rotation.z + i), &sc, &cc);
+	sx = _mm256_loadu_ps(scale.x + i);
+	sy = _mm256_loadu_ps(scale.y + i);
+	sz = _mm256_loadu_ps(scale.z + i);
+	zero = _mm256_setzero_ps();
+
+	columns[0] = _mm256_mul_ps(_mm256_mul_ps(cb, cc), sx);
+	columns[1] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(ca, sc), _mm256_mul_ps(_mm256_mul_ps(sa, sb), cc)), sx);
+	columns[2] = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(sa, sc), _mm256_mul_ps(_mm256_mul_ps(ca, sb), cc)), sx);
+	columns[3] = zero;
+	columns[4] = _mm256_sub_ps(zero, _mm256_mul_ps(_mm256_mul_ps(cb, sc), sy));
+	columns[5] = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(ca, cc), _mm256_mul_ps(_mm256_mul_ps(sa, sb), sc)), sy);
+	columns[6] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sa, cc), _mm256_mul_ps(_mm256_mul_ps(ca, sb), sc)), sy);
+	columns[7] = zero;
+	columns[8] = _mm256_mul_ps(sb, sz);
+	columns[9] = _mm256_sub_ps(zero, _mm256_mul_ps(_mm256_mul_ps(sa, cb), sz));
+	columns[10] = _mm256_mul_ps(_mm256_mul_ps(ca, cb), sz);
+	columns[11] = zero;
+	columns[12] = _mm256_loadu_ps(position.x + i);
+	columns[13] = _mm256_loadu_ps(position.y + i);
+	columns[14] = _mm256_loadu_ps(position.z + i);
+	columns[15] = _mm256_set1_ps(1.0f);
+
+	for (k = 0; k < 16; ++k) {
+		lo[k] = _mm256_castps256_ps128(columns[k]);
+		hi[k] = _mm256_extractf128_ps(columns[k], 1);
+	}
+	store_mat4_x4_sse2(out + i, lo);
+	store_mat4_x4_sse2(out + i + 4, hi);
+}
+
+static int32_t frustum_cull_x8_avx2(uint8_t *visible, const struct frustum *f, struct vec3_soa center, struct vec3_soa extent, int32_t i)
+{
+	__m256 cx, cy, cz, ex, ey, ez, distance, radius, inside;
+	int32_t p, mask;
+
+	cx = _mm256_loadu_ps(center.x + i);
+	cy = _mm256_loadu_ps(center.y + i);
+	cz = _mm256_loadu_ps(center.z + i);
+	ex = _mm256_loadu_ps(extent.x + i);
+	ey = _mm256_loadu_ps(extent.y + i);
+	ez = _mm256_loadu_ps(extent.z + i);
+	inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+	for (p = 0; p < 6; ++p) {
+		struct vec4 plane = f->planes[p];
+		distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_mul_ps(cy, _mm256_set1_ps(plane.y))), _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+		radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(fabsf(plane.x))), _mm256_mul_ps(ey, _mm256_set1_ps(fabsf(plane.y)))), _mm256_mul_ps(ez, _mm256_set1_ps(fabsf(plane.z))));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+	}
+
+	mask = _mm256_movemask_ps(inside);
+	for (p = 0; p < 8; ++p) {
+		visible[i + p] = (uint8_t)((mask >> p) & 1);
+	}
+	return __builtin_popcount((unsigned int)mask);
+}
+
+static void quat_rotate_x8_avx2(struct vec3_soa out, struct vec3_soa v, const struct quat *q, int32_t i)
+{
+	__m256 vx, vy, vz, qx, qy, qz, qw, tx, ty, tz, two;
+
+	vx = _mm256_loadu_ps(v.x + i);
+	vy = _mm256_loadu_ps(v.y + i);
+	vz = _mm256_loadu_ps(v.z + i);
+	qx = _mm256_set1_ps(q->x);
+	qy = _mm256_set1_ps(q->y);
+	qz = _mm256_set1_ps(q->z);
+	qw = _mm256_set1_ps(q->w);
+	two = _mm256_set1_ps(2.0f);
+
+	tx = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(qy, vz), _mm256_mul_ps(qz, vy)), _mm256_mul_ps(qw, vx));
+	ty = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(qz, vx), _mm256_mul_ps(qx, vz)), _mm256_mul_ps(qw, vy));
+	tz = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(qx, vy), _mm256_mul_ps(qy, vx)), _mm256_mul_ps(qw, vz));
+	_mm256_storeu_ps(out.x + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(qy, tz), _mm256_mul_ps(qz, ty)), two), vx));
+	_mm256_storeu_ps(out.y + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(qz, tx), _mm256_mul_ps(qx, tz)), two), vy));
+	_mm256_storeu_ps(out.z + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(qx, ty), _mm256_mul_ps(qy, tx)), two), vz));
+}
+
+static void vec3_transform_x8_avx2(struct vec3_soa out, const struct mat4 *m, struct vec3_soa p, int32_t i)
+{
+	__m256 px, py, pz;
+
+	px = _mm256_loadu_ps(p.x + i);
+	py = _mm256_loadu_ps(p.y + i);
+	pz = _mm256_loadu_ps(p.z + i);
+	_mm256_storeu_ps(out.x + i, _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m->x.x), px), _mm256_mul_ps(_mm256_set1_ps(m->y.x), py)), _mm256_mul_ps(_mm256_set1_ps(m->z.x), pz)), _mm256_set1_ps(m->w.x)));
+	_mm256_storeu_ps(out.y + i, _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m->x.y), px), _mm256_mul_ps(_mm256_set1_ps(m->y.y), py)), _mm256_mul_ps(_mm256_set1_ps(m->z.y), pz)), _mm256_set1_ps(m->w.y)));
+	_mm256_storeu_ps(out.z + i, _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m->x.z), px), _mm256_mul_ps(_mm256_set1_ps(m->y.z), py)), _mm256_mul_ps(_mm256_set1_ps(m->z.z), pz)), _mm256_set1_ps(m->w.z)));
+}
+
+/* the lower and upper 4 lanes of 8 compositions, ready for the x4 stores */
+static void trs_columns_x8_avx2(__m128 *lo, __m128 *hi, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t i)
+{
+	__m256 qx, qy, qz, qw, x2, y2, z2, xx, yy, zz, xy, xz, yz, wx, wy, wz, sx, sy, sz, one, zero;
+	__m256 columns[16];
+	int32_t k;
+
+	qx = _mm256_loadu_ps(rotation.x + i);
+	qy = _mm256_loadu_ps(rotation.y + i);
+	qz = _mm256_loadu_ps(rotation.z + i);
+	qw = _mm256_loadu_ps(rotation.w + i);
+	x2 = _mm256_add_ps(qx, qx);
+	y2 = _mm256_add_ps(qy, qy);
+	z2 = _mm256_add_ps(qz, qz);
+	xx = _mm256_mul_ps(qx, x2);
+	yy = _mm256_mul_ps(qy, y2);
+	zz = _mm256_mul_ps(qz, z2);
+	xy = _mm256_mul_ps(qx, y2);
+	xz = _mm256_mul_ps(qx, z2);
+	yz = _mm256_mul_ps(qy, z2);
+	wx = _mm256_mul_ps(qw, x2);
+	wy = _mm256_mul_ps(qw, y2);
+	wz = _mm256_mul_ps(qw, z2);
+	sx = _mm256_loadu_ps(scale.x + i);
+	sy = _mm256_loadu_ps(scale.y + i);
+	sz = _mm256_loadu_ps(scale.z + i);
+	one = _mm256_set1_ps(1.0f);
+	zero = _mm256_setzero_ps();
+
+	columns[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx);
+	columns[1] = _mm256_mul_ps(_mm256_add_ps(xy, wz), sx);
+	columns[2] = _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx);
+	columns[3] = zero;
+	columns[4] = _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy);
+	columns[5] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy);
+	columns[6] = _mm256_mul_ps(_mm256_add_ps(yz, wx), sy);
+	columns[7] = zero;
+	columns[8] = _mm256_mul_ps(_mm256_add_ps(xz, wy), sz);
+	columns[9] = _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz);
+	columns[10] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz);
+	columns[11] = zero;
+	columns[12] = _mm256_loadu_ps(position.x + i);
+	columns[13] = _mm256_loadu_ps(position.y + i);
+	columns[14] = _mm256_loadu_ps(position.z + i);
+	columns[15] = one;
+
+	for (k = 0; k < 16; ++k) {
+		lo[k] = _mm256_castps256_ps128(columns[k]);
+		hi[k] = _mm256_extractf128_ps(columns[k], 1);
+	}
+}
+
+static void mat4_compose_trs_x8_avx2(struct mat4 *out, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t i)
+{
+	__m128 lo[16], hi[16];
+
+	trs_columns_x8_avx2(lo, hi, position, rotation, scale, i);
+	store_mat4_x4_sse2(out + i, lo);
+	store_mat4_x4_sse2(out + i + 4, hi);
+}
+
+static void affine_compose_trs_x8_avx2(struct affine3x4 *out, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t i)
+{
+	__m128 lo[16], hi[16];
+
+	trs_columns_x8_avx2(lo, hi, position, rotation, scale, i);
+	store_affine_x4_sse2(out + i, lo);
+	store_affine_x4_sse2(out + i + 4, hi);
+}
+#endif
+
+void mat4_compose_euler_soa(struct mat4 *out, struct vec3_soa position, struct vec3_soa rotation, struct vec3_soa scale, int32_t count)
+{
+	int32_t i = 0;
+
+#if defined(__AVX2__)
+	for (; i + 8 <= count; i += 8) {
+		mat4_compose_euler_x8_avx2(out, position, rotation, scale, i);
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		mat4_compose_euler_x4_sse2(out, position, rotation, scale, i);
+	}
+#endif
+	for (; i < count; ++i) {
+		out[i] = mat4_compose_euler(v3(position.x[i], position.y[i], position.z[i]), v3(rotation.x[i], rotation.y[i], rotation.z[i]), v3(scale.x[i], scale.y[i], scale.z[i]));
+	}
+}
+
+int32_t frustum_cull_soa(uint8_t *visible, struct frustum f, struct vec3_soa center, struct vec3_soa extent, int32_t count)
+{
+	int32_t i = 0, visible_count = 0;
+
+#if defined(__AVX2__)
+	for (; i + 8 <= count; i += 8) {
+		visible_count += frustum_cull_x8_avx2(visible, &f, center, extent, i);
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		visible_count += frustum_cull_x4_sse2(visible, &f, center, extent, i);
+	}
+#endif
+	for (; i < count; ++i) {
+		visible[i] = (uint8_t)frustum_test_aabb(f, v3(center.x[i], center.y[i], center.z[i]), v3(extent.x[i], extent.y[i], extent.z[i]));
+		visible_count += visible[i];
+	}
+	return visible_count;
+}
+
+void mat4_multiply_array(struct mat4 *out, struct mat4 m, const struct mat4 *in, int32_t count)
+{
+	math_kernels.mat4_multiply_array(out, &m, in, count);
+}
+
+void quat_rotate_soa(struct vec3_soa out, struct vec3_soa v, struct quat q, int32_t count)
+{
+	float tx, ty, tz, vx, vy, vz;
+	int32_t i = 0;
+
+#if defined(__AVX2__)
+	for (; i + 8 <= count; i += 8) {
+		quat_rotate_x8_avx2(out, v, &q, i);
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		quat_rotate_x4_sse2(out, v, &q, i);
+	}
+#endif
+	/* quat_rotate written out in the order of the SIMD kernels */
+	for (; i < count; ++i) {
+		vx = v.x[i];
+		vy = v.y[i];
+		vz = v.z[i];
+		tx = (q.y * vz - q.z * vy) + q.w * vx;
+		ty = (q.z * vx - q.x * vz) + q.w * vy;
+		tz = (q.x * vy - q.y * vx) + q.w * vz;
+		out.x[i] = (q.y * tz - q.z * ty) * 2.0f + vx;
+		out.y[i] = (q.z * tx - q.x * tz) * 2.0f + vy;
+		out.z[i] = (q.x * ty - q.y * tx) * 2.0f + vz;
+	}
+}
+
+void vec3_transform_soa(struct vec3_soa out, struct mat4 m, struct vec3_soa p, int32_t count)
+{
+	float px, py, pz;
+	int32_t i = 0;
+
+#if defined(__AVX2__)
+	for (; i + 8 <= count; i += 8) {
+		vec3_transform_x8_avx2(out, &m, p, i);
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		vec3_transform_x4_sse2(out, &m, p, i);
+	}
+#endif
+	for (; i < count; ++i) {
+		px = p.x[i];
+		py = p.y[i];
+		pz = p.z[i];
+		out.x[i] = m.x.x * px + m.y.x * py + m.z.x * pz + m.w.x;
+		out.y[i] = m.x.y * px + m.y.y * py + m.z.y * pz + m.w.y;
+		out.z[i] = m.x.z * px + m.y.z * py + m.z.z * pz + m.w.z;
+	}
+}
+
+/* translate * rotate(quat) * scale, rotation quaternions are expected to be unit length */
+void mat4_compose_trs_soa(struct mat4 *out, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t count)
+{
+	struct quat q;
+	int32_t i = 0;
+
+#if defined(__AVX2__)
+	for (; i + 8 <= count; i += 8) {
+		mat4_compose_trs_x8_avx2(out, position, rotation, scale, i);
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		mat4_compose_trs_x4_sse2(out, position, rotation, scale, i);
+	}
+#endif
+	for (; i < count; ++i) {
+		q.x = rotation.x[i];
+		q.y = rotation.y[i];
+		q.z = rotation.z[i];
+		q.w = rotation.w[i];
+		out[i] = mat4_from_trs(v3(position.x[i], position.y[i], position.z[i]), q, v3(scale.x[i], scale.y[i], scale.z[i]));
+	}
+}
+
+void affine_compose_trs_soa(struct affine3x4 *out, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t count)
+{
+	struct quat q;
+	int32_t i = 0;
+
+#if defined(__AVX2__)
+	for (; i + 8 <= count; i += 8) {
+		affine_compose_trs_x8_avx2(out, position, rotation, scale, i);
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		affine_compose_trs_x4_sse2(out, position, rotation, scale, i);
+	}
+#endif
+	for (; i < count; ++i) {
+		q.x = rotation.x[i];
+		q.y = rotation.y[i];
+		q.z = rotation.z[i];
+		q.w = rotation.w[i];
+		out[i] = affine_from_trs(v3(position.x[i], position.y[i], position.z[i]), q, v3(scale.x[i], scale.y[i], scale.z[i]));
+	}
+}
+
+/*
+ * SIMD mat4 kernels. SSE2 is part of x86-64 and picked at compile time like
+ * the kernels above, AVX is compiled in on any x86 build and only used when
+ * the cpu reports it. both keep the scalar order of operations.
+ */
+
+#if defined(__SSE2__)
+static void mat4_add_sse2(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1)
+{
+	const float *a = &m0->x.x;
+	const float *b = &m1->x.x;
+	float *c = &out->x.x;
+	int32_t i;
+
+	for (i = 0; i < 16; i += 4) {
+		_mm_storeu_ps(c + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	}
+}
+
+/* each column of the result is the columns of m0 weighted by one column of m1 */
+static void mat4_multiply_sse2(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1)
+{
+	const float *b;
+	__m128 a0, a1, a2, a3, c[4];
+	int32_t i;
+
+	a0 = _mm_loadu_ps(&m0->x.x);
+	a1 = _mm_loadu_ps(&m0->y.x);
+	a2 = _mm_loadu_ps(&m0->z.x);
+	a3 = _mm_loadu_ps(&m0->w.x);
+	for (i = 0; i < 4; ++i) {
+		b = &m1->x.x + i * 4;
+		c[i] = _mm_mul_ps(a0, _mm_set1_ps(b[0]));
+		c[i] = _mm_add_ps(c[i], _mm_mul_ps(a1, _mm_set1_ps(b[1])));
+		c[i] = _mm_add_ps(c[i], _mm_mul_ps(a2, _mm_set1_ps(b[2])));
+		c[i] = _mm_add_ps(c[i], _mm_mul_ps(a3, _mm_set1_ps(b[3])));
+	}
+	/* out may be m0 or m1, only store once both are read */
+	_mm_storeu_ps(&out->x.x, c[0]);
+	_mm_storeu_ps(&out->y.x, c[1]);
+	_mm_storeu_ps(&out->z.x, c[2]);
+	_mm_storeu_ps(&out->w.x, c[3]);
+}
+
+static void mat4_multiply_scalar_sse2(struct mat4 *out, const struct mat4 *m, float f)
+{
+	const float *a = &m->x.x;
+	float *b = &out->x.x;
+	__m128 scalar;
+	int32_t i;
+
+	scalar = _mm_set1_ps(f);
+	for (i = 0; i < 16; i += 4) {
+		_mm_storeu_ps(b + i, _mm_mul_ps(_mm_loadu_ps(a + i), scalar));
+	}
+}
+
+/* mat4_multiply_sse2 with the columns of m loaded once */
+static void mat4_multiply_array_sse2(struct mat4 *out, const struct mat4 *m, const struct mat4 *in, int32_t count)
+{
+	const float *b;
+	__m128 a0, a1, a2, a3, c[4];
+	int32_t i, j;
+
+	a0 = _mm_loadu_ps(&m->x.x);
+	a1 = _mm_loadu_ps(&m->y.x);
+	a2 = _mm_loadu_ps(&m->z.x);
+	a3 = _mm_loadu_ps(&m->w.x);
+	for (i = 0; i < count; ++i) {
+		for (j = 0; j < 4; ++j) {
+			b = &in[i].x.x + j * 4;
+			c[j] = _mm_mul_ps(a0, _mm_set1_ps(b[0]));
+			c[j] = _mm_add_ps(c[j], _mm_mul_ps(a1, _mm_set1_ps(b[1])));
+			c[j] = _mm_add_ps(c[j], _mm_mul_ps(a2, _mm_set1_ps(b[2])));
+			c[j] = _mm_add_ps(c[j], _mm_mul_ps(a3, _mm_set1_ps(b[3])));
+		}
+		_mm_storeu_ps(&out[i].x.x, c[0]);
+		_mm_storeu_ps(&out[i].y.x, c[1]);
+		_mm_storeu_ps(&out[i].z.x, c[2]);
+		_mm_storeu_ps(&out[i].w.x, c[3]);
+	}
+}
+
+#define WATT_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(w, z, y, x))
+
+/* 2x2 matrices held row major in one register, a * b */
+static __m128 mat2_multiply_sse2(__m128 a, __m128 b)
+{
+	return _mm_add_ps(_mm_mul_ps(a, WATT_SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(WATT_SWIZZLE(a, 1, 0, 3, 2), WATT_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+/* adjugate(a) * b */
+static __m128 mat2_adjugate_multiply_sse2(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(WATT_SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(WATT_SWIZZLE(a, 1, 1, 2, 2), WATT_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+/* a * adjugate(b) */
+static __m128 mat2_multiply_adjugate_sse2(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, WATT_SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(WATT_SWIZZLE(a, 1, 0, 3, 2), WATT_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+/*
+ * blockwise inverse over the four 2x2 blocks, the columns are treated as
+ * rows like in mat4_inverse_c. with m = [a b; c d] and # the adjugate, the
+ * inverse is [x y; z w] / |m| where
+ *
+ * x# = |d| a - b (d# c)    y# = |b| c - d (a# b)#
+ * z# = |c| b - a (d# c)#   w# = |a| d - c (a# b)
+ * |m| = |a| |d| + |b| |c| - tr((a# b) (d# c))
+ */
+static void mat4_inverse_sse2(struct mat4 *out, const struct mat4 *m)
+{
+	__m128 r0, r1, r2, r3, a, b, c, d, det_sub, det_a, det_b, det_c, det_d;
+	__m128 a_b, d_c, x, y, z, w, det, trace, inv_det;
+
+	r0 = _mm_loadu_ps(&m->x.x);
+	r1 = _mm_loadu_ps(&m->y.x);
+	r2 = _mm_loadu_ps(&m->z.x);
+	r3 = _mm_loadu_ps(&m->w.x);
+	a = _mm_movelh_ps(r0, r1);
+	b = _mm_movehl_ps(r1, r0);
+	c = _mm_movelh_ps(r2, r3);
+	d = _mm_movehl_ps(r3, r2);
+
+	/* (|a|, |b|, |c|, |d|) */
+	det_sub = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+	det_a = WATT_SWIZZLE(det_sub, 0, 0, 0, 0);
+	det_b = WATT_SWIZZLE(det_sub, 1, 1, 1, 1);
+	det_c = WATT_SWIZZLE(det_sub, 2, 2, 2, 2);
+	det_d = WATT_SWIZZLE(det_sub, 3, 3, 3, 3);
+
+	d_c = mat2_adjugate_multiply_sse2(d, c);
+	a_b = mat2_adjugate_multiply_sse2(a, b);
+	x = _mm_sub_ps(_mm_mul_ps(det_d, a), mat2_multiply_sse2(b, d_c));
+	w = _mm_sub_ps(_mm_mul_ps(det_a, d), mat2_multiply_sse2(c, a_b));
+	y = _mm_sub_ps(_mm_mul_ps(det_b, c), mat2_multiply_adjugate_sse2(d, a_b));
+	z = _mm_sub_ps(_mm_mul_ps(det_c, b), mat2_multiply_adjugate_sse2(a, d_c));
+
+	trace = _mm_mul_ps(a_b, WATT_SWIZZLE(d_c, 0, 2, 1, 3));
+	trace = _mm_add_ps(trace, WATT_SWIZZLE(trace, 1, 0, 3, 2));
+	trace = _mm_add_ps(trace, WATT_SWIZZLE(trace, 2, 3, 0, 1));
+	det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), trace);
+
+	/* the signs turn x#, y#, z#, w# back into x, y, z, w once their elements are swapped below */
+	inv_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = _mm_mul_ps(x, inv_det);
+	y = _mm_mul_ps(y, inv_det);
+	z = _mm_mul_ps(z, inv_det);
+	w = _mm_mul_ps(w, inv_det);
+
+	_mm_storeu_ps(&out->x.x, _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(&out->y.x, _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(&out->z.x, _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(&out->w.x, _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+}
+
+#undef WATT_SWIZZLE
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WATT_MATH_AVX_DISPATCH 1
+#include <immintrin.h> /* AVX */
+
+__attribute__((target("avx"))) static void mat4_add_avx(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1)
+{
+	__m256 lo, hi;
+
+	lo = _mm256_add_ps(_mm256_loadu_ps(&m0->x.x), _mm256_loadu_ps(&m1->x.x));
+	hi = _mm256_add_ps(_mm256_loadu_ps(&m0->z.x), _mm256_loadu_ps(&m1->z.x));
+	_mm256_storeu_ps(&out->x.x, lo);
+	_mm256_storeu_ps(&out->z.x, hi);
+}
+
+/* two result columns per register, both halves hold the same m0 column */
+__attribute__((target("avx"))) static void mat4_multiply_avx(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1)
+{
+	__m256 a0, a1, a2, a3, b01, b23, c01, c23;
+
+	a0 = _mm256_broadcast_ps((const __m128 *)&m0->x);
+	a1 = _mm256_broadcast_ps((const __m128 *)&m0->y);
+	a2 = _mm256_broadcast_ps((const __m128 *)&m0->z);
+	a3 = _mm256_broadcast_ps((const __m128 *)&m0->w);
+	b01 = _mm256_loadu_ps(&m1->x.x);
+	b23 = _mm256_loadu_ps(&m1->z.x);
+
+	c01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+	c01 = _mm256_add_ps(c01, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+	c01 = _mm256_add_ps(c01, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xaa)));
+	c01 = _mm256_add_ps(c01, _mm256_mul_ps(a3, _mm256_permute_ps(b01, 0xff)));
+	c23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+	c23 = _mm256_add_ps(c23, _mm256_mul_ps(a1, _mm256_permute_ps(b23, 0x55)));
+	c23 = _mm256_add_ps(c23, _mm256_mul_ps(a2, _mm256_permute_ps(b23, 0xaa)));
+	c23 = _mm256_add_ps(c23, _mm256_mul_ps(a3, _mm256_permute_ps(b23, 0xff)));
+
+	_mm256_storeu_ps(&out->x.x, c01);
+	_mm256_storeu_ps(&out->z.x, c23);
+}
+
+__attribute__((target("avx"))) static void mat4_multiply_scalar_avx(struct mat4 *out, const struct mat4 *m, float f)
+{
+	__m256 scalar, lo, hi;
+
+	scalar = _mm256_set1_ps(f);
+	lo = _mm256_mul_ps(_mm256_loadu_ps(&m->x.x), scalar);
+	hi = _mm256_mul_ps(_mm256_loadu_ps(&m->z.x), scalar);
+	_mm256_storeu_ps(&out->x.x, lo);
+	_mm256_storeu_ps(&out->z.x, hi);
+}
+
+/* mat4_multiply_avx with the columns of m broadcast once */
+__attribute__((target("avx"))) static void mat4_multiply_array_avx(struct mat4 *out, const struct mat4 *m, const struct mat4 *in, int32_t count)
+{
+	__m256 a0, a1, a2, a3, b01, b23, c01, c23;
+	int32_t i;
+
+	a0 = _mm256_broadcast_ps((const __m128 *)&m->x);
+	a1 = _mm256_broadcast_ps((const __m128 *)&m->y);
+	a2 = _mm256_broadcast_ps((const __m128 *)&m->z);
+	a3 = _mm256_broadcast_ps((const __m128 *)&m->w);
+	for (i = 0; i < count; ++i) {
+		b01 = _mm256_loadu_ps(&in[i].x.x);
+		b23 = _mm256_loadu_ps(&in[i].z.x);
+		c01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+		c01 = _mm256_add_ps(c01, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+		c01 = _mm256_add_ps(c01, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xaa)));
+		c01 = _mm256_add_ps(c01, _mm256_mul_ps(a3, _mm256_permute_ps(b01, 0xff)));
+		c23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+		c23 = _mm256_add_ps(c23, _mm256_mul_ps(a1, _mm256_permute_ps(b23, 0x55)));
+		c23 = _mm256_add_ps(c23, _mm256_mul_ps(a2, _mm256_permute_ps(b23, 0xaa)));
+		c23 = _mm256_add_ps(c23, _mm256_mul_ps(a3, _mm256_permute_ps(b23, 0xff)));
+		_mm256_storeu_ps(&out[i].x.x, c01);
+		_mm256_storeu_ps(&out[i].z.x, c23);
+	}
+}
+#endif
+
+int32_t math_backend_supported(int32_t backend)
+{
+	switch (backend) {
+	case MATH_BACKEND_SCALAR:
+		return 1;
+#if defined(__SSE2__)
+	case MATH_BACKEND_SSE2:
+		return 1;
+#endif
+#if defined(WATT_MATH_AVX_DISPATCH)
+	case MATH_BACKEND_AVX:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx") != 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
+int32_t math_backend_set(int32_t backend)
+{
+	struct math_kernels kernels = {mat4_add_c, mat4_multiply_c, mat4_multiply_scalar_c, mat4_multiply_array_c, mat4_inverse_c};
+
+	if (!math_backend_supported(backend)) {
+		return 0;
+	}
+#if defined(__SSE2__)
+	if (backend == MATH_BACKEND_SSE2) {
+		kernels.mat4_add = mat4_add_sse2;
+		kernels.mat4_multiply = mat4_multiply_sse2;
+		kernels.mat4_multiply_scalar = mat4_multiply_scalar_sse2;
+		kernels.mat4_multiply_array = mat4_multiply_array_sse2;
+		kernels.mat4_inverse = mat4_inverse_sse2;
+	}
+#endif
+#if defined(WATT_MATH_AVX_DISPATCH)
+	if (backend == MATH_BACKEND_AVX) {
+		kernels.mat4_add = mat4_add_avx;
+		kernels.mat4_multiply = mat4_multiply_avx;
+		kernels.mat4_multiply_scalar = mat4_multiply_scalar_avx;
+		kernels.mat4_multiply_array = mat4_multiply_array_avx;
+#if defined(__SSE2__)
+		/* one 4x4 inverse is 4 wide, avx has nothing to add */
+		kernels.mat4_inverse = mat4_inverse_sse2;
+#endif
+	}
+#endif
+	math_kernels = kernels;
+	math_kernels_backend = backend;
+	return 1;
+}
+
+int32_t math_backend(void)
+{
+	return math_kernels_backend;
+}
+
+const char *math_backend_name(int32_t backend)
+{
+	static const char *const names[MATH_BACKEND_COUNT] = {"scalar", "sse2", "avx"};
+
+	assert(backend >= 0 && backend < MATH_BACKEND_COUNT);
+	return names[backend];
+}
+
+/* picks the best backend before main, so the kernels never change while threads use them */
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+static void math_backend_init(void)
+{
+	int32_t backend;
+
+	for (backend = MATH_BACKEND_COUNT - 1; backend > MATH_BACKEND_SCALAR; --backend) {
+		if (math_backend_set(backend)) {
+			break;
+		}
+	}
+}
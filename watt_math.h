@@ -6,6 +6,22 @@
 #define WATT_PI32 3.14159265359f
 #define WATT_RAD_FROM_DEG(deg) (deg / 180.0f * WATT_PI32)
 
+/*
+ * kernels behind mat4_add, mat4_multiply, mat4_multiply_scalar,
+ * mat4_multiply_array and mat4_inverse. the best one the cpu supports is picked at startup,
+ * math_backend_set switches them for tests and benchmarks and must not
+ * race with other math calls.
+ */
+#define MATH_BACKEND_SCALAR 0
+#define MATH_BACKEND_SSE2 1
+#define MATH_BACKEND_AVX 2
+#define MATH_BACKEND_COUNT 3
+
+/* frustum_classify_aabb results */
+#define FRUSTUM_OUTSIDE 0
+#define FRUSTUM_INTERSECTS 1
+#define FRUSTUM_INSIDE 2
+
 struct vec2 v2(float x, float y);
 
 struct vec3 v3(float x, float y, float z);
@@ -20,13 +36,23 @@ float vec3_length(struct vec3 a);
 struct vec4 v4(float x, float y, float z, float w);
 
 struct quat quat_axis_angle(struct vec3 axis, float rad);
+struct quat quat_from_euler(struct vec3 rotation);
 struct quat quat_multiply(struct quat a, struct quat b);
+struct quat quat_normalize(struct quat q);
 struct vec3 quat_rotate(struct vec3 v, struct quat q);
 
 struct mat4 mat4_identity(void);
 struct mat4 mat4_add(struct mat4 m0, struct mat4 m1);
 struct mat4 mat4_multiply(struct mat4 m0, struct mat4 m1);
 struct mat4 mat4_multiply_scalar(struct mat4 m, float f);
+struct mat4 mat4_inverse(struct mat4 m); /* m has to be invertible */
+
+/* like the above without copying matrices in and out, out may be one of the inputs */
+void mat4_add_into(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1);
+void mat4_multiply_into(struct mat4 *out, const struct mat4 *m0, const struct mat4 *m1);
+void mat4_multiply_scalar_into(struct mat4 *out, const struct mat4 *m, float f);
+void mat4_inverse_into(struct mat4 *out, const struct mat4 *m);
+
 struct mat4 mat4_scale(struct mat4 m, struct vec3 v);
 struct mat4 mat4_translate(struct mat4 m, struct vec3 v);
 struct mat4 mat4_rotate_x(struct mat4 m, float rad);
@@ -34,5 +60,65 @@ struct mat4 mat4_rotate_y(struct mat4 m, float rad);
 struct mat4 mat4_rotate_z(struct mat4 m, float rad);
 struct mat4 mat4_look_at(struct vec3 look_from, struct vec3 look_dir, struct vec3 look_up);
 struct mat4 mat4_perspective(float fov, float aspect, float z_near, float z_far);
+struct mat4 mat4_compose_euler(struct vec3 position, struct vec3 rotation, struct vec3 scale);
+struct mat4 mat4_from_trs(struct vec3 position, struct quat rotation, struct vec3 scale);
+
+struct affine3x4 affine_identity(void);
+struct affine3x4 affine_from_mat4(struct mat4 m); /* drops the bottom row, m has to be affine */
+struct mat4 affine_to_mat4(struct affine3x4 a);
+struct affine3x4 affine_from_trs(struct vec3 position, struct quat rotation, struct vec3 scale);
+struct affine3x4 affine_multiply(struct affine3x4 a, struct affine3x4 b);
+struct affine3x4 affine_inverse(struct affine3x4 a);
+struct affine3x4 affine_inverse_rigid(struct affine3x4 a); /* rotation and translation only */
+struct vec3 affine_transform_point(struct affine3x4 a, struct vec3 p);
+struct vec3 affine_transform_normal(struct affine3x4 a, struct vec3 n);
+
+struct aabb aabb_union(struct aabb a, struct aabb b);
+struct aabb aabb_transform(struct aabb a, struct mat4 m);
+struct aabb aabb_transform_affine(struct aabb a, struct affine3x4 m);
+int32_t ray_intersect_aabb(struct vec3 origin, struct vec3 direction, struct aabb box, float max_distance, float *distance);
+
+/*
+ * world position of a normalized device coordinate, ndc x and y and depth in
+ * -1..1 (gl style), through the inverse of the view projection matrix
+ */
+struct vec3 unproject(struct vec2 ndc, float depth, struct mat4 inv_view_proj);
+/* ray from the near plane through ndc towards the far plane */
+struct ray unproject_ray(struct vec2 ndc, struct mat4 inv_view_proj);
+
+struct frustum frustum_from_mat4(struct mat4 view_proj);
+int32_t frustum_test_aabb(struct frustum f, struct vec3 center, struct vec3 extent);
+int32_t frustum_classify_aabb(struct frustum f, struct vec3 center, struct vec3 extent);
+
+/* batched frustum_test_aabb, writes 0/1 per element to visible and returns the visible count */
+int32_t frustum_cull_soa(uint8_t *visible, struct frustum f, struct vec3_soa center, struct vec3_soa extent, int32_t count);
+
+int32_t math_backend_supported(int32_t backend);
+int32_t math_backend_set(int32_t backend); /* 0 when the backend isn't supported */
+int32_t math_backend(void);
+const char *math_backend_name(int32_t backend);
+
+/* batched mat4_compose_euler over count elements, 4 (SSE2) or 8 (AVX2) at a time */
+void mat4_compose_euler_soa(struct mat4 *out, struct vec3_soa position, struct vec3_soa rotation, struct vec3_soa scale, int32_t count);
+
+/*
+ * array kernels, 4 (SSE2) or 8 (AVX2) elements at a time. out may be the
+ * input stream.
+ */
+
+/* out[i] = m * in[i] on the math backend, like mat4_multiply */
+void mat4_multiply_array(struct mat4 *out, struct mat4 m, const struct mat4 *in, int32_t count);
+
+/* quat_rotate of count vectors by one quaternion */
+void quat_rotate_soa(struct vec3_soa out, struct vec3_soa v, struct quat q, int32_t count);
+
+/* m * (p, 1) for count points, without a perspective divide */
+void vec3_transform_soa(struct vec3_soa out, struct mat4 m, struct vec3_soa p, int32_t count);
+
+/* batched mat4_from_trs, the quaternion counterpart of mat4_compose_euler_soa */
+void mat4_compose_trs_soa(struct mat4 *out, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t count);
+
+/* batched affine_from_trs */
+void affine_compose_trs_soa(struct affine3x4 *out, struct vec3_soa position, struct quat_soa rotation, struct vec3_soa scale, int32_t count);
 
 #endif
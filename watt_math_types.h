@@ -47,4 +47,58 @@ struct mat4 {
 
 typedef struct mat4 mat4;
 
+/*
+ * affine transforms, the top three rows of a mat4 whose bottom row is
+ * (0, 0, 0, 1). stored row by row so each row is one vec4 instance
+ * attribute, w holds the translation.
+ *
+ * [x.x, x.y, x.z, x.w]
+ * [y.x, y.y, y.z, y.w]
+ * [z.x, z.y, z.z, z.w]
+ * [  0,   0,   0,   1]
+ *
+ */
+
+struct affine3x4 {
+	struct vec4 x;
+	struct vec4 y;
+	struct vec4 z;
+};
+
+struct aabb {
+	struct vec3 min;
+	struct vec3 max;
+};
+
+struct ray {
+	struct vec3 origin;
+	struct vec3 direction; /* unit length */
+};
+
+/*
+ * planes as (normal, distance), a point p is inside when
+ * dot(normal, p) + distance >= 0 for all of left, right, bottom, top, near, far
+ */
+
+struct frustum {
+	struct vec4 planes[6];
+};
+
+/*
+ * structure of arrays view over many vec3s, element i is (x[i], y[i], z[i])
+ */
+
+struct vec3_soa {
+	float *x;
+	float *y;
+	float *z;
+};
+
+struct quat_soa {
+	float *x;
+	float *y;
+	float *z;
+	float *w;
+};
+
 #endif
@@ -0,0 +1,431 @@
+#include "watt_mesh.h"
+#include "watt_base64.h"
+#include "watt_math.h"
+
+#define CGLTF_IMPLEMENTATION
+#include "cgltf.h"
+
+#include <math.h>   /* INFINITY, fminf, fmaxf, lrintf */
+#include <stdio.h>  /* fopen, fwrite, fclose */
+#include <stdlib.h> /* malloc, free */
+#include <string.h> /* memset, memcmp, memcpy, strchr, strrchr, strlen, strncmp */
+#include <assert.h> /* assert */
+
+void mesh_data_free(struct mesh_data *data)
+{
+	free(data->meshes);
+	free(data->submeshes);
+	free(data->vertices);
+	free(data->indices);
+	memset(data, 0, sizeof(*data));
+}
+
+/* attribute of a primitive by type, 0 when the primitive doesn't have it */
+static const cgltf_accessor *gltf_find_attribute(const cgltf_primitive *prim, cgltf_attribute_type type)
+{
+	cgltf_size i;
+	for (i = 0; i < prim->attributes_count; ++i) {
+		if (prim->attributes[i].type == type && prim->attributes[i].index == 0) {
+			return prim->attributes[i].data;
+		}
+	}
+	return 0;
+}
+
+/*
+ * reads count elements of an accessor as floats, zero fills when the accessor
+ * is missing. returns 0 when it holds a different count or can't be read.
+ */
+static int32_t gltf_read_floats(const cgltf_accessor *acc, float *out, int32_t component_count, int32_t count)
+{
+	int32_t i;
+	if (!acc) {
+		memset(out, 0, (size_t)count * (size_t)component_count * sizeof(float));
+		return 1;
+	}
+	if ((int32_t)acc->count != count) {
+		return 0;
+	}
+	for (i = 0; i < count; ++i) {
+		if (!cgltf_accessor_read_float(acc, (cgltf_size)i, out + i * component_count, (cgltf_size)component_count)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int16_t quantize_snorm16(float f)
+{
+	return (int16_t)lrintf(fminf(fmaxf(f, -1.0f), 1.0f) * 32767.0f);
+}
+
+static int8_t quantize_snorm8(float f)
+{
+	return (int8_t)lrintf(fminf(fmaxf(f, -1.0f), 1.0f) * 127.0f);
+}
+
+/* scale of a [min, max] range mapped to [-1, 1], flat ranges keep a scale of 1 */
+static float quantize_scale(float min, float max)
+{
+	return (max > min) ? (max - min) * 0.5f : 1.0f;
+}
+
+/*
+ * converts the primitives of all meshes in a file into one array of
+ * struct packed_vertex and one index array. positions and texcoords are
+ * quantized against the bounds of their mesh, which the shader undoes with
+ * the mesh's dequantization uniforms. indices are rebased onto the packed
+ * vertices, so all submeshes of a file can share their bindings and only
+ * differ in base_element, non-indexed primitives get sequential indices.
+ * the float staging is pushed on arena and released before returning.
+ */
+static int32_t gltf_to_mesh_data(cgltf_data *gltf, struct mesh_data *data, struct buffer_arena *arena)
+{
+	struct buffer_arena_mark staging_mark;
+	float *positions, *normals, *texcoords;
+	int32_t submesh_idx, vertex_base, index_base, mesh_vertex_base;
+	int32_t prim_vertex_count, prim_index_count;
+	int32_t i, j, k;
+	cgltf_size prim_index;
+	uint32_t index;
+	const cgltf_primitive *prim;
+	const cgltf_accessor *position_accessor;
+	struct mesh_data_mesh *mesh;
+	struct mesh_data_submesh *submesh;
+	struct packed_vertex *vertex;
+	struct vec2 texcoord_min, texcoord_max;
+	struct aabb bounds;
+	const float *p;
+
+	memset(data, 0, sizeof(*data));
+	if (gltf->meshes_count == 0) {
+		return 0;
+	}
+
+	for (i = 0; i < (int32_t)gltf->meshes_count; ++i) {
+		for (j = 0; j < (int32_t)gltf->meshes[i].primitives_count; ++j) {
+			prim = &gltf->meshes[i].primitives[j];
+			position_accessor = gltf_find_attribute(prim, cgltf_attribute_type_position);
+			if (!position_accessor) {
+				return 0;
+			}
+			data->vertex_count += (int32_t)position_accessor->count;
+			data->index_count += (int32_t)(prim->indices ? prim->indices->count : position_accessor->count);
+			++data->submesh_count;
+		}
+	}
+	data->mesh_count = (int32_t)gltf->meshes_count;
+
+	/* rebased indices only stay 16 bit while the packed vertices fit */
+	data->index_size = (data->vertex_count <= 0x10000) ? (int32_t)sizeof(uint16_t) : (int32_t)sizeof(uint32_t);
+
+	data->meshes = malloc((size_t)data->mesh_count * sizeof(struct mesh_data_mesh));
+	data->submeshes = malloc((size_t)data->submesh_count * sizeof(struct mesh_data_submesh));
+	data->vertices = malloc((size_t)data->vertex_count * sizeof(struct packed_vertex));
+	data->indices = malloc((size_t)data->index_count * (size_t)data->index_size);
+
+	/* float staging for one file, quantized into vertices mesh by mesh */
+	staging_mark = buffer_arena_mark(arena);
+	positions = buffer_arena_push(arena, (uint64_t)data->vertex_count * 3 * sizeof(float), 0);
+	normals = buffer_arena_push(arena, (uint64_t)data->vertex_count * 3 * sizeof(float), 0);
+	texcoords = buffer_arena_push(arena, (uint64_t)data->vertex_count * 2 * sizeof(float), 0);
+	if (!data->meshes || !data->submeshes || !data->vertices || !data->indices || !positions || !normals || !texcoords) {
+		buffer_arena_reset(arena, staging_mark);
+		mesh_data_free(data);
+		return 0;
+	}
+
+	submesh_idx = 0;
+	vertex_base = 0;
+	index_base = 0;
+
+	for (i = 0; i < data->mesh_count; ++i) {
+		mesh = &data->meshes[i];
+		mesh->submesh_start = submesh_idx;
+		mesh->submesh_count = (int32_t)gltf->meshes[i].primitives_count;
+
+		mesh_vertex_base = vertex_base;
+		for (j = 0; j < mesh->submesh_count; ++j) {
+			prim = &gltf->meshes[i].primitives[j];
+			submesh = &data->submeshes[submesh_idx++];
+
+			position_accessor = gltf_find_attribute(prim, cgltf_attribute_type_position);
+			prim_vertex_count = (int32_t)position_accessor->count;
+			if (!gltf_read_floats(position_accessor, positions + vertex_base * 3, 3, prim_vertex_count)
+				|| !gltf_read_floats(gltf_find_attribute(prim, cgltf_attribute_type_normal), normals + vertex_base * 3, 3, prim_vertex_count)
+				|| !gltf_read_floats(gltf_find_attribute(prim, cgltf_attribute_type_texcoord), texcoords + vertex_base * 2, 2, prim_vertex_count)) {
+				buffer_arena_reset(arena, staging_mark);
+				mesh_data_free(data);
+				return 0;
+			}
+
+			prim_index_count = prim->indices ? (int32_t)prim->indices->count : prim_vertex_count;
+			for (k = 0; k < prim_index_count; ++k) {
+				prim_index = prim->indices ? cgltf_accessor_read_index(prim->indices, (cgltf_size)k) : (cgltf_size)k;
+				if (prim_index >= (cgltf_size)prim_vertex_count) {
+					buffer_arena_reset(arena, staging_mark);
+					mesh_data_free(data);
+					return 0;
+				}
+				index = (uint32_t)prim_index + (uint32_t)vertex_base;
+				if (data->index_size == sizeof(uint16_t)) {
+					((uint16_t *)data->indices)[index_base + k] = (uint16_t)index;
+				} else {
+					((uint32_t *)data->indices)[index_base + k] = index;
+				}
+			}
+
+			submesh->bounds.min = v3(INFINITY, INFINITY, INFINITY);
+			submesh->bounds.max = v3(-INFINITY, -INFINITY, -INFINITY);
+			for (k = vertex_base; k < vertex_base + prim_vertex_count; ++k) {
+				p = &positions[k * 3];
+				submesh->bounds.min = v3(fminf(submesh->bounds.min.x, p[0]), fminf(submesh->bounds.min.y, p[1]), fminf(submesh->bounds.min.z, p[2]));
+				submesh->bounds.max = v3(fmaxf(submesh->bounds.max.x, p[0]), fmaxf(submesh->bounds.max.y, p[1]), fmaxf(submesh->bounds.max.z, p[2]));
+			}
+			mesh->bounds = (j == 0) ? submesh->bounds : aabb_union(mesh->bounds, submesh->bounds);
+
+			submesh->base_element = index_base;
+			submesh->element_count = prim_index_count;
+			vertex_base += prim_vertex_count;
+			index_base += prim_index_count;
+		}
+
+		/* quantize the mesh against its position and texcoord bounds */
+		texcoord_min = v2(INFINITY, INFINITY);
+		texcoord_max = v2(-INFINITY, -INFINITY);
+		for (k = mesh_vertex_base; k < vertex_base; ++k) {
+			texcoord_min = v2(fminf(texcoord_min.x, texcoords[k * 2]), fminf(texcoord_min.y, texcoords[k * 2 + 1]));
+			texcoord_max = v2(fmaxf(texcoord_max.x, texcoords[k * 2]), fmaxf(texcoord_max.y, texcoords[k * 2 + 1]));
+		}
+		bounds = mesh->bounds;
+		mesh->position_scale = v4(quantize_scale(bounds.min.x, bounds.max.x), quantize_scale(bounds.min.y, bounds.max.y), quantize_scale(bounds.min.z, bounds.max.z), 0.0f);
+		mesh->position_offset = v4((bounds.min.x + bounds.max.x) * 0.5f, (bounds.min.y + bounds.max.y) * 0.5f, (bounds.min.z + bounds.max.z) * 0.5f, 0.0f);
+		mesh->texcoord_transform = v4(
+			quantize_scale(texcoord_min.x, texcoord_max.x),
+			quantize_scale(texcoord_min.y, texcoord_max.y),
+			(texcoord_min.x + texcoord_max.x) * 0.5f,
+			(texcoord_min.y + texcoord_max.y) * 0.5f);
+
+		for (k = mesh_vertex_base; k < vertex_base; ++k) {
+			vertex = &data->vertices[k];
+			vertex->position[0] = quantize_snorm16((positions[k * 3] - mesh->position_offset.x) / mesh->position_scale.x);
+			vertex->position[1] = quantize_snorm16((positions[k * 3 + 1] - mesh->position_offset.y) / mesh->position_scale.y);
+			vertex->position[2] = quantize_snorm16((positions[k * 3 + 2] - mesh->position_offset.z) / mesh->position_scale.z);
+			vertex->position[3] = 0;
+			vertex->normal[0] = quantize_snorm8(normals[k * 3]);
+			vertex->normal[1] = quantize_snorm8(normals[k * 3 + 1]);
+			vertex->normal[2] = quantize_snorm8(normals[k * 3 + 2]);
+			vertex->normal[3] = 0;
+			vertex->texcoord[0] = quantize_snorm16((texcoords[k * 2] - mesh->texcoord_transform.z) / mesh->texcoord_transform.x);
+			vertex->texcoord[1] = quantize_snorm16((texcoords[k * 2 + 1] - mesh->texcoord_transform.w) / mesh->texcoord_transform.y);
+		}
+	}
+
+	buffer_arena_reset(arena, staging_mark);
+	return 1;
+}
+
+/*
+ * decodes base64 data uris with base64_decode ahead of cgltf_load_buffers,
+ * which skips buffers that already have data. the buffers are allocated
+ * like cgltf's own, through options, so they are released with the rest of the file.
+ */
+static cgltf_result gltf_decode_data_uris(const cgltf_options *options, cgltf_data *gltf)
+{
+	cgltf_size i;
+	cgltf_buffer *buffer;
+	const char *comma;
+	uint8_t *data;
+
+	for (i = 0; i < gltf->buffers_count; ++i) {
+		buffer = &gltf->buffers[i];
+		if (buffer->data || !buffer->uri || strncmp(buffer->uri, "data:", 5) != 0) {
+			continue;
+		}
+		comma = strchr(buffer->uri, ',');
+		if (!comma || comma - buffer->uri < 7 || strncmp(comma - 7, ";base64", 7) != 0) {
+			continue;
+		}
+		/* base64_decode reads (size * 4 + 2) / 3 characters, shorter uris are left to cgltf's error path */
+		if (strlen(comma + 1) < (buffer->size * 4 + 2) / 3) {
+			continue;
+		}
+
+		data = options->memory_alloc ? options->memory_alloc(options->memory_user_data, buffer->size) : malloc(buffer->size);
+		if (!data) {
+			return cgltf_result_out_of_memory;
+		}
+		if (!base64_decode(data, buffer->size, comma + 1)) {
+			if (options->memory_free) {
+				options->memory_free(options->memory_user_data, data);
+			} else {
+				free(data);
+			}
+			return cgltf_result_io_error;
+		}
+		buffer->data = data;
+	}
+	return cgltf_result_success;
+}
+
+/* cgltf allocates from a load arena, its frees are no-ops and the whole file is released by one reset */
+static void *gltf_arena_alloc(void *user, cgltf_size size)
+{
+	return buffer_arena_push(user, (uint64_t)size, 0);
+}
+
+static void gltf_arena_free(void *user, void *ptr)
+{
+	(void)user;
+	(void)ptr;
+}
+
+int32_t mesh_data_from_gltf(const char *filename, const void *contents, size_t size, struct mesh_data *data, struct buffer_arena *arena)
+{
+	struct buffer_arena_mark file_mark = buffer_arena_mark(arena);
+	cgltf_options options;
+	cgltf_data *gltf = NULL;
+	int32_t result;
+
+	memset(data, 0, sizeof(*data));
+	memset(&options, 0, sizeof(options));
+	options.memory_alloc = gltf_arena_alloc;
+	options.memory_free = gltf_arena_free;
+	options.memory_user_data = arena;
+	if (cgltf_parse(&options, contents, size, &gltf) != cgltf_result_success) {
+		buffer_arena_reset(arena, file_mark);
+		return 0;
+	}
+
+	/* a bad base64 data uri or a missing external buffer fails the load like a bad parse */
+	if (gltf_decode_data_uris(&options, gltf) != cgltf_result_success
+		|| cgltf_load_buffers(&options, gltf, filename) != cgltf_result_success) {
+		buffer_arena_reset(arena, file_mark);
+		return 0;
+	}
+
+	result = gltf_to_mesh_data(gltf, data, arena);
+
+	/* instead of cgltf_free */
+	buffer_arena_reset(arena, file_mark);
+	return result;
+}
+
+int32_t mesh_data_load_gltf(const char *filename, struct mesh_data *data, struct buffer_arena *arena)
+{
+	struct buffer file = buffer_map_file(filename);
+	int32_t result;
+
+	if (file.size == 0) {
+		memset(data, 0, sizeof(*data));
+		return 0;
+	}
+	result = mesh_data_from_gltf(filename, file.data, (size_t)file.size, data, arena);
+	buffer_destroy(&file);
+	return result;
+}
+
+static uint64_t mesh_pack_align(uint64_t offset)
+{
+	return (offset + MESH_PACK_ALIGNMENT - 1) & ~(uint64_t)(MESH_PACK_ALIGNMENT - 1);
+}
+
+struct mesh_pack_header mesh_pack_header_for(uint32_t mesh_count, uint32_t submesh_count, uint32_t vertex_count, uint32_t index_count, uint32_t index_size)
+{
+	struct mesh_pack_header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = MESH_PACK_MAGIC;
+	header.version = MESH_PACK_VERSION;
+	header.vertex_size = sizeof(struct packed_vertex);
+	header.index_size = index_size;
+	header.mesh_count = mesh_count;
+	header.submesh_count = submesh_count;
+	header.vertex_count = vertex_count;
+	header.index_count = index_count;
+	header.meshes_offset = mesh_pack_align(sizeof(header));
+	header.submeshes_offset = mesh_pack_align(header.meshes_offset + (uint64_t)mesh_count * sizeof(struct mesh_data_mesh));
+	header.vertices_offset = mesh_pack_align(header.submeshes_offset + (uint64_t)submesh_count * sizeof(struct mesh_data_submesh));
+	header.indices_offset = mesh_pack_align(header.vertices_offset + (uint64_t)vertex_count * sizeof(struct packed_vertex));
+	header.size = header.indices_offset + (uint64_t)index_count * index_size;
+	return header;
+}
+
+int32_t mesh_pack_filename(char *out, size_t size, const char *gltf_filename)
+{
+	const char *extension = strrchr(gltf_filename, '.');
+	size_t stem_length = extension ? (size_t)(extension - gltf_filename) : strlen(gltf_filename);
+
+	if (stem_length + sizeof(MESH_PACK_EXTENSION) > size) {
+		return 0;
+	}
+	memcpy(out, gltf_filename, stem_length);
+	memcpy(out + stem_length, MESH_PACK_EXTENSION, sizeof(MESH_PACK_EXTENSION));
+	return 1;
+}
+
+int32_t mesh_data_from_pack(const uint8_t *pack, size_t size, struct mesh_data *data)
+{
+	const struct mesh_pack_header *header;
+	struct mesh_pack_header expected;
+
+	if (size < sizeof(struct mesh_pack_header)) {
+		return 0;
+	}
+	header = (const struct mesh_pack_header *)pack;
+	expected = mesh_pack_header_for(header->mesh_count, header->submesh_count, header->vertex_count, header->index_count, header->index_size);
+	if (memcmp(header, &expected, sizeof(expected)) != 0 || expected.size != (uint64_t)size) {
+		return 0;
+	}
+
+	data->mesh_count = (int32_t)header->mesh_count;
+	data->submesh_count = (int32_t)header->submesh_count;
+	data->vertex_count = (int32_t)header->vertex_count;
+	data->index_count = (int32_t)header->index_count;
+	data->index_size = (int32_t)header->index_size;
+	data->meshes = (struct mesh_data_mesh *)(pack + header->meshes_offset);
+	data->submeshes = (struct mesh_data_submesh *)(pack + header->submeshes_offset);
+	data->vertices = (struct packed_vertex *)(pack + header->vertices_offset);
+	data->indices = (void *)(pack + header->indices_offset);
+	return 1;
+}
+
+/* writes zeros up to target_offset, then size bytes of data */
+static int32_t write_padded(FILE *file, const void *data, uint64_t size, uint64_t *offset, uint64_t target_offset)
+{
+	static const uint8_t zeros[MESH_PACK_ALIGNMENT] = {0};
+
+	assert(target_offset >= *offset && target_offset - *offset <= sizeof(zeros));
+	if (fwrite(zeros, 1, (size_t)(target_offset - *offset), file) != (size_t)(target_offset - *offset)) {
+		return 0;
+	}
+	if (size > 0 && fwrite(data, 1, (size_t)size, file) != (size_t)size) {
+		return 0;
+	}
+	*offset = target_offset + size;
+	return 1;
+}
+
+int32_t mesh_pack_write(const char *filename, const struct mesh_data *data)
+{
+	struct mesh_pack_header header = mesh_pack_header_for(
+		(uint32_t)data->mesh_count,
+		(uint32_t)data->submesh_count,
+		(uint32_t)data->vertex_count,
+		(uint32_t)data->index_count,
+		(uint32_t)data->index_size);
+	uint64_t offset = 0;
+	int32_t result;
+	FILE *file;
+
+	file = fopen(filename, "wb");
+	if (!file) {
+		return 0;
+	}
+	result = write_padded(file, &header, sizeof(header), &offset, 0) &&
+		write_padded(file, data->meshes, (uint64_t)data->mesh_count * sizeof(struct mesh_data_mesh), &offset, header.meshes_offset) &&
+		write_padded(file, data->submeshes, (uint64_t)data->submesh_count * sizeof(struct mesh_data_submesh), &offset, header.submeshes_offset) &&
+		write_padded(file, data->vertices, (uint64_t)data->vertex_count * sizeof(struct packed_vertex), &offset, header.vertices_offset) &&
+		write_padded(file, data->indices, (uint64_t)data->index_count * (uint64_t)data->index_size, &offset, header.indices_offset);
+	assert(!result || offset == header.size);
+	return (fclose(file) == 0) && result;
+}
@@ -0,0 +1,117 @@
+#ifndef WATT_MESH_H
+#define WATT_MESH_H
+
+#include "watt_buffer.h"
+#include "watt_math_types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * cpu side geometry of one file, converted from gltf or mapped from a mesh
+ * pack
+ *
+ * all meshes of a file share one vertex and one index array. submesh_start
+ * is relative to the file and base_element to its index array.
+ */
+
+/*
+ * interleaved vertex, 16 bytes instead of 32 for separate float streams.
+ * position and texcoord are snorm relative to the bounds of their mesh,
+ * see the dequantization fields of struct mesh_data_mesh.
+ */
+struct packed_vertex {
+	int16_t position[4]; /* SHORT4N, w unused */
+	int8_t normal[4];    /* BYTE4N, w unused */
+	int16_t texcoord[2]; /* SHORT2N */
+};
+
+struct mesh_data_mesh {
+	int32_t submesh_start;
+	int32_t submesh_count;
+	struct aabb bounds;
+	struct vec4 position_scale;
+	struct vec4 position_offset;
+	struct vec4 texcoord_transform; /* xy scale, zw offset */
+};
+
+struct mesh_data_submesh {
+	int32_t base_element;
+	int32_t element_count;
+	struct aabb bounds;
+};
+
+struct mesh_data {
+	int32_t mesh_count;
+	int32_t submesh_count;
+	int32_t vertex_count;
+	int32_t index_count;
+	int32_t index_size; /* 2 or 4 bytes */
+	struct mesh_data_mesh *meshes;
+	struct mesh_data_submesh *submeshes;
+	struct packed_vertex *vertices;
+	void *indices;
+};
+
+/* frees the arrays of decoded data, never of data pointing into a pack */
+void mesh_data_free(struct mesh_data *data);
+
+/*
+ * parses and decodes gltf file contents. external buffer uris are resolved
+ * next to filename. everything cgltf allocates and the float staging live
+ * on arena and are released before returning, only data's arrays stay on
+ * the heap. returns 0 and leaves data empty for bad files, files without
+ * meshes or primitives without positions, and when out of memory. touches
+ * no global state, so workers can decode files on their own arenas.
+ */
+int32_t mesh_data_from_gltf(const char *filename, const void *contents, size_t size, struct mesh_data *data, struct buffer_arena *arena);
+
+/* mesh_data_from_gltf on a whole file */
+int32_t mesh_data_load_gltf(const char *filename, struct mesh_data *data, struct buffer_arena *arena);
+
+/*
+ * mesh pack, a mesh_data written by mesh_pack_write: the header, then the
+ * meshes, submeshes, vertices and indices arrays at MESH_PACK_ALIGNMENT
+ * aligned offsets, in native byte order so the mapped file is used as is
+ */
+
+#define MESH_PACK_MAGIC 0x4b504d57u /* "WMPK" */
+#define MESH_PACK_VERSION 1
+#define MESH_PACK_ALIGNMENT 16
+#define MESH_PACK_EXTENSION ".pack"
+
+struct mesh_pack_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertex_size; /* sizeof(struct packed_vertex) at cook time */
+	uint32_t index_size;
+	uint32_t mesh_count;
+	uint32_t submesh_count;
+	uint32_t vertex_count;
+	uint32_t index_count;
+	uint64_t meshes_offset;
+	uint64_t submeshes_offset;
+	uint64_t vertices_offset;
+	uint64_t indices_offset;
+	uint64_t size;
+};
+
+/* header of a pack holding the given counts, the arrays follow in header order */
+struct mesh_pack_header mesh_pack_header_for(uint32_t mesh_count, uint32_t submesh_count, uint32_t vertex_count, uint32_t index_count, uint32_t index_size);
+
+/*
+ * path of the pack next to a gltf file: its extension replaced by
+ * MESH_PACK_EXTENSION. returns 0 when it doesn't fit in size bytes.
+ */
+int32_t mesh_pack_filename(char *out, size_t size, const char *gltf_filename);
+
+/*
+ * points data into a pack, nothing is copied. returns 0 when the pack was
+ * cooked for another layout.
+ */
+int32_t mesh_data_from_pack(const uint8_t *pack, size_t size, struct mesh_data *data);
+
+/* returns 0 when the file can't be written */
+int32_t mesh_pack_write(const char *filename, const struct mesh_data *data);
+
+#endif
@@ -0,0 +1,145 @@
+#include "watt_pool.h"
+
+#include <stdlib.h> /* realloc, free */
+#include <string.h> /* memset, memcpy */
+#include <assert.h> /* assert */
+
+int32_t pool_init(struct pool *pool, uint32_t item_size, uint32_t capacity)
+{
+	assert(pool && item_size > 0);
+	memset(pool, 0, sizeof(*pool));
+	pool->item_size = item_size;
+	return pool_reserve(pool, capacity > 0 ? capacity : 1);
+}
+
+int32_t pool_reserve(struct pool *pool, uint32_t capacity)
+{
+	assert(pool);
+	if (capacity <= pool->capacity) {
+		return 1;
+	}
+	assert(capacity <= POOL_SLOT_MASK);
+
+	void *items = realloc(pool->items, (size_t)capacity * pool->item_size);
+	if (!items) {
+		return 0;
+	}
+	pool->items = items;
+
+	uint32_t *item_slots = realloc(pool->item_slots, (size_t)capacity * sizeof(uint32_t));
+	if (!item_slots) {
+		return 0;
+	}
+	pool->item_slots = item_slots;
+
+	uint32_t *slot_items = realloc(pool->slot_items, (size_t)capacity * sizeof(uint32_t));
+	if (!slot_items) {
+		return 0;
+	}
+	pool->slot_items = slot_items;
+
+	uint32_t *slot_ids = realloc(pool->slot_ids, (size_t)capacity * sizeof(uint32_t));
+	if (!slot_ids) {
+		return 0;
+	}
+	pool->slot_ids = slot_ids;
+
+	pool->capacity = capacity;
+	return 1;
+}
+
+uint32_t pool_add(struct pool *pool)
+{
+	assert(pool);
+	if (pool->count == pool->capacity) {
+		if (!pool_reserve(pool, pool->capacity * 2)) {
+			return POOL_INVALID_ID;
+		}
+	}
+
+	uint32_t slot, id;
+	if (pool->free_slot < pool->slot_count) {
+		slot = pool->free_slot;
+		pool->free_slot = pool->slot_items[slot];
+		id = pool->slot_ids[slot];
+	} else {
+		slot = pool->slot_count++;
+		pool->free_slot = pool->slot_count;
+		id = (1u << POOL_SLOT_BITS) | slot;
+		pool->slot_ids[slot] = id;
+	}
+
+	uint32_t index = pool->count++;
+	pool->slot_items[slot] = index;
+	pool->item_slots[index] = slot;
+	memset(pool_item(pool, index), 0, pool->item_size);
+	return id;
+}
+
+void pool_remove(struct pool *pool, uint32_t id)
+{
+	assert(pool && pool_get(pool, id));
+	uint32_t slot = id & POOL_SLOT_MASK;
+	uint32_t index = pool->slot_items[slot];
+	uint32_t last = --pool->count;
+
+	if (index != last) {
+		memcpy(pool_item(pool, index), pool_item(pool, last), pool->item_size);
+		uint32_t moved_slot = pool->item_slots[last];
+		pool->item_slots[index] = moved_slot;
+		pool->slot_items[moved_slot] = index;
+	}
+
+	/* bump the generation now so stale handles to this slot stop resolving */
+	uint32_t generation = ((id >> POOL_SLOT_BITS) + 1) & (0xffffffffu >> POOL_SLOT_BITS);
+	pool->slot_ids[slot] = ((generation ? generation : 1) << POOL_SLOT_BITS) | slot;
+	pool->slot_items[slot] = pool->free_slot;
+	pool->free_slot = slot;
+}
+
+void pool_clear(struct pool *pool)
+{
+	assert(pool);
+	while (pool->count > 0) {
+		pool_remove(pool, pool_item_id(pool, pool->count - 1));
+	}
+}
+
+void *pool_get(struct pool *pool, uint32_t id)
+{
+	uint32_t index = pool_index(pool, id);
+	return (index != POOL_INVALID_INDEX) ? pool_item(pool, index) : 0;
+}
+
+/* dense index of a live item, stable until the next pool_remove */
+uint32_t pool_index(struct pool *pool, uint32_t id)
+{
+	assert(pool);
+	uint32_t slot = id & POOL_SLOT_MASK;
+	if (id == POOL_INVALID_ID || slot >= pool->slot_count || pool->slot_ids[slot] != id) {
+		return POOL_INVALID_INDEX;
+	}
+	return pool->slot_items[slot];
+}
+
+void *pool_item(struct pool *pool, uint32_t index)
+{
+	assert(pool && index < pool->capacity);
+	return (uint8_t *)pool->items + (size_t)index * pool->item_size;
+}
+
+uint32_t pool_item_id(struct pool *pool, uint32_t index)
+{
+	assert(pool && index < pool->count);
+	return pool->slot_ids[pool->item_slots[index]];
+}
+
+void pool_destroy(struct pool *pool)
+{
+	assert(pool);
+	free(pool->items);
+	free(pool->item_slots);
+	free(pool->slot_items);
+	free(pool->slot_ids);
+	memset(pool, 0, sizeof(*pool));
+}
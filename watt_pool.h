@@ -0,0 +1,44 @@
+#ifndef WATT_POOL_H
+#define WATT_POOL_H
+
+#include <stdint.h>
+
+/*
+ * growable pool of fixed size items
+ *
+ * items are kept densely packed in insertion order (removal moves the last
+ * item into the hole) so they can be iterated as a plain array, while
+ * handles stay valid until their item is removed. handle ids carry the
+ * slot index in the low bits and a generation counter in the high bits,
+ * 0 is never a valid id.
+ */
+
+#define POOL_INVALID_ID 0
+#define POOL_INVALID_INDEX 0xffffffffu
+#define POOL_SLOT_BITS 24
+#define POOL_SLOT_MASK ((1u << POOL_SLOT_BITS) - 1)
+
+struct pool {
+	void *items;          /* dense item storage, count items */
+	uint32_t *item_slots; /* dense index -> slot */
+	uint32_t *slot_items; /* slot -> dense index, or next free slot */
+	uint32_t *slot_ids;   /* slot -> current handle id */
+	uint32_t item_size;
+	uint32_t count;
+	uint32_t capacity;
+	uint32_t slot_count;
+	uint32_t free_slot; /* head of the free-list, slot_count when empty */
+};
+
+int32_t pool_init(struct pool *pool, uint32_t item_size, uint32_t capacity);
+int32_t pool_reserve(struct pool *pool, uint32_t capacity);
+uint32_t pool_add(struct pool *pool);
+void pool_remove(struct pool *pool, uint32_t id);
+void pool_clear(struct pool *pool);
+void *pool_get(struct pool *pool, uint32_t id);
+uint32_t pool_index(struct pool *pool, uint32_t id);
+void *pool_item(struct pool *pool, uint32_t index);
+uint32_t pool_item_id(struct pool *pool, uint32_t index);
+void pool_destroy(struct pool *pool);
+
+#endif
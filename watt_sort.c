@@ -0,0 +1,54 @@
+#include "watt_sort.h"
+
+#include <string.h> /* memset, memcpy */
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+void radix_sort_u64(uint64_t *keys, uint64_t *scratch, int32_t count)
+{
+	uint32_t histograms[RADIX_PASSES][RADIX_SIZE];
+	uint32_t offset, digit_count;
+	uint64_t *src, *dst, *tmp;
+	int32_t pass, shift, i;
+
+	if (count < 2) {
+		return;
+	}
+
+	/* one read of the keys counts the digits of every pass */
+	memset(histograms, 0, sizeof(histograms));
+	for (i = 0; i < count; ++i) {
+		for (pass = 0; pass < RADIX_PASSES; ++pass) {
+			++histograms[pass][(keys[i] >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)];
+		}
+	}
+
+	src = keys;
+	dst = scratch;
+	for (pass = 0; pass < RADIX_PASSES; ++pass) {
+		shift = pass * RADIX_BITS;
+		if (histograms[pass][(src[0] >> shift) & (RADIX_SIZE - 1)] == (uint32_t)count) {
+			continue;
+		}
+
+		offset = 0;
+		for (i = 0; i < RADIX_SIZE; ++i) {
+			digit_count = histograms[pass][i];
+			histograms[pass][i] = offset;
+			offset += digit_count;
+		}
+		for (i = 0; i < count; ++i) {
+			dst[histograms[pass][(src[i] >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+		}
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if (src != keys) {
+		memcpy(keys, src, (size_t)count * sizeof(uint64_t));
+	}
+}
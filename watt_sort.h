@@ -0,0 +1,14 @@
+#ifndef WATT_SORT_H
+#define WATT_SORT_H
+
+#include <stdint.h>
+
+/*
+ * ascending lsd radix sort of 64 bit keys, 8 bits per pass. digits that are
+ * the same in every key are skipped, so keys that only use a few bits sort
+ * in a few passes. scratch must hold count keys. callers keep a payload in
+ * the low bits of the key, e.g. an index into their own array.
+ */
+void radix_sort_u64(uint64_t *keys, uint64_t *scratch, int32_t count);
+
+#endif